@@ -52,15 +52,20 @@ all: prebuild prelink $(TARGET) $(OBJDIR)
 
 BAKE_SOURCE= ..\src\attribute.c \
 			..\src\build.c \
+			..\src\builddb.c \
 			..\src\bundle.c \
+			..\src\changes.c \
 			..\src\config.c \
 			..\src\crawler.c \
+			..\src\daemon.c \
 			..\src\driver.c \
 			..\src\filelist.c \
 			..\src\git.c \
 			..\src\install.c \
+			..\src\jobs.c \
 			..\src\json_utils.c \
 			..\src\main.c \
+			..\src\metadata.c \
 			..\src\project.c \
 			..\src\rule.c \
 			..\src\run.c \
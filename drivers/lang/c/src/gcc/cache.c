@@ -0,0 +1,328 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Object cache for gcc compilers and similar. Objects are stored in
+ * $BAKE_HOME/cache/obj with a key that is computed from the compiler, the
+ * compiler flags and the preprocessed source, so that objects can be reused
+ * across projects, branches and configurations. When the cache grows beyond
+ * its maximum size, the least recently used objects are removed. */
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#define GCC_CACHE_PATH "cache"UT_OS_PS"obj"
+
+typedef struct gcc_cache_entry {
+    char *file;
+    time_t modified;
+    uint64_t size;
+} gcc_cache_entry;
+
+/* Size of the objects in the cache, computed when first object is added */
+static uint64_t gcc_cache_used;
+static bool gcc_cache_used_known;
+
+static
+bool gcc_cache_enabled(
+    bake_config *config,
+    bake_project *project)
+{
+    /* Coverage and build profiling generate files other than the object */
+    return config->object_cache && !config->assembly && !config->profile_build &&
+        !(config->coverage && project->coverage);
+}
+
+static
+uint64_t gcc_cache_file_size(
+    const char *file)
+{
+    struct stat st;
+    if (stat(file, &st)) {
+        return 0;
+    }
+    return st.st_size;
+}
+
+/* Identify compiler by its location, size and modification time, so that
+ * objects are not reused after the compiler is upgraded. */
+static
+char* gcc_cache_compiler_id(
+    const char *compiler)
+{
+    char *file = NULL;
+
+    if (strchr(compiler, UT_OS_PS[0])) {
+        file = ut_strdup(compiler);
+    } else {
+        char *path = ut_strdup(ut_getenv("PATH"));
+        char *dir = path, *next;
+        do {
+            if ((next = strchr(dir, UT_ENV_PATH_SEPARATOR[0]))) {
+                next[0] = '\0';
+            }
+            file = ut_asprintf("%s"UT_OS_PS"%s", dir, compiler);
+            if (ut_file_test(file) == 1) {
+                break;
+            }
+            free(file);
+            file = NULL;
+            dir = next + 1;
+        } while (next);
+        free(path);
+    }
+
+    if (!file || ut_file_test(file) != 1) {
+        ut_catch();
+        free(file);
+        return NULL;
+    }
+
+    char *result = ut_asprintf("%s %llu %lld", file,
+        (unsigned long long)gcc_cache_file_size(file),
+        (long long)ut_lastmodified(file));
+
+    free(file);
+
+    return result;
+}
+
+/* Compute key for preprocessed source. Returns NULL if the key can't be
+ * computed because the preprocessed source can't be read. */
+static
+char* gcc_cache_key(
+    bake_config *config,
+    const char *compiler,
+    const char *flags,
+    const char *pp_file)
+{
+    uint64_t pp_hash;
+
+    if (ut_file_test(pp_file) != 1 || ut_file_hash(pp_file, &pp_hash)) {
+        ut_catch();
+        return NULL;
+    }
+
+    char *compiler_id = gcc_cache_compiler_id(compiler);
+    if (!compiler_id) {
+        ut_trace("#[grey]cannot identify compiler '%s', not caching", compiler);
+        return NULL;
+    }
+
+    uint64_t hash = ut_hash_str(UT_HASH_INIT, compiler_id);
+    hash = ut_hash_str(hash, flags);
+
+    /* Debug information contains the working directory */
+    if (config->symbols) {
+        hash = ut_hash_str(hash, ut_cwd());
+    }
+
+    free(compiler_id);
+
+    return ut_asprintf("%016"PRIx64"%016"PRIx64, hash, pp_hash);
+}
+
+static
+char* gcc_cache_file(
+    bake_config *config,
+    const char *key)
+{
+    return ut_asprintf("%s"UT_OS_PS GCC_CACHE_PATH UT_OS_PS"%.2s"UT_OS_PS"%s.o",
+        config->home, key, key);
+}
+
+/* Copy object from cache to target. Returns false if not in cache. */
+static
+bool gcc_cache_get(
+    bake_config *config,
+    const char *key,
+    const char *target)
+{
+    char *file = gcc_cache_file(config, key);
+    bool result = false;
+
+    if (ut_file_test(file) == 1 && !ut_cp(file, target)) {
+        /* Mark object as recently used */
+        utime(file, NULL);
+        result = true;
+    }
+
+    ut_catch();
+    free(file);
+
+    return result;
+}
+
+static
+int gcc_cache_compare(
+    const void *e1,
+    const void *e2)
+{
+    const gcc_cache_entry *entry1 = e1, *entry2 = e2;
+    if (entry1->modified < entry2->modified) {
+        return -1;
+    } else if (entry1->modified > entry2->modified) {
+        return 1;
+    }
+    return 0;
+}
+
+/* Collect objects in cache, and compute size of cache */
+static
+gcc_cache_entry* gcc_cache_scan(
+    bake_config *config,
+    uint32_t *count_out)
+{
+    char *cache_path = ut_asprintf("%s"UT_OS_PS GCC_CACHE_PATH, config->home);
+    gcc_cache_entry *result = NULL;
+    uint32_t count = 0, capacity = 0;
+    ut_iter it;
+
+    gcc_cache_used = 0;
+
+    if (ut_dir_iter(cache_path, NULL, &it)) {
+        ut_catch();
+        goto done;
+    }
+
+    while (ut_iter_hasNext(&it)) {
+        char *dir = ut_asprintf(
+            "%s"UT_OS_PS"%s", cache_path, (char*)ut_iter_next(&it));
+        ut_iter file_it;
+
+        if (!ut_isdir(dir) || ut_dir_iter(dir, NULL, &file_it)) {
+            ut_catch();
+            free(dir);
+            continue;
+        }
+
+        while (ut_iter_hasNext(&file_it)) {
+            char *name = ut_iter_next(&file_it);
+            char *ext = strrchr(name, '.');
+            if (!ext || strcmp(ext, ".o")) {
+                continue;
+            }
+
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 256;
+                result = realloc(result, capacity * sizeof(gcc_cache_entry));
+            }
+
+            gcc_cache_entry *entry = &result[count ++];
+            entry->file = ut_asprintf("%s"UT_OS_PS"%s", dir, name);
+            entry->modified = ut_lastmodified(entry->file);
+            entry->size = gcc_cache_file_size(entry->file);
+            gcc_cache_used += entry->size;
+        }
+
+        free(dir);
+    }
+
+done:
+    gcc_cache_used_known = true;
+    free(cache_path);
+    *count_out = count;
+    return result;
+}
+
+static
+void gcc_cache_free_entries(
+    gcc_cache_entry *entries,
+    uint32_t count)
+{
+    uint32_t i;
+    for (i = 0; i < count; i ++) {
+        free(entries[i].file);
+    }
+    free(entries);
+}
+
+/* Remove least recently used objects until cache is below maximum size */
+static
+void gcc_cache_evict(
+    bake_config *config)
+{
+    uint64_t max = (uint64_t)config->object_cache_size * 1024 * 1024;
+    uint32_t i, count;
+
+    gcc_cache_entry *entries = gcc_cache_scan(config, &count);
+    if (gcc_cache_used > max) {
+        /* Leave some room, so eviction doesn't happen for every object */
+        uint64_t target = max - max / 10;
+
+        qsort(entries, count, sizeof(gcc_cache_entry), gcc_cache_compare);
+
+        for (i = 0; i < count && gcc_cache_used > target; i ++) {
+            if (!ut_rm(entries[i].file)) {
+                gcc_cache_used -= entries[i].size;
+            } else {
+                ut_catch();
+            }
+        }
+
+        ut_trace("#[grey]evicted %u objects from cache", i);
+    }
+
+    gcc_cache_free_entries(entries, count);
+}
+
+/* Add target to cache */
+static
+void gcc_cache_put(
+    bake_config *config,
+    const char *key,
+    const char *target)
+{
+    char *file = gcc_cache_file(config, key);
+
+    /* Copy to temporary file first, so other processes never observe a
+     * partially written object */
+    char *tmp_file = ut_asprintf("%s.%d.tmp", file, (int)getpid());
+
+    if (ut_cp(target, tmp_file) || ut_rename(tmp_file, file)) {
+        ut_catch();
+        ut_rm(tmp_file);
+        ut_catch();
+    } else {
+        if (!gcc_cache_used_known) {
+            uint32_t count;
+            gcc_cache_entry *entries = gcc_cache_scan(config, &count);
+            gcc_cache_free_entries(entries, count);
+        } else {
+            gcc_cache_used += gcc_cache_file_size(file);
+        }
+
+        /* A maximum size of 0 means that the cache size is not limited */
+        uint64_t max = (uint64_t)config->object_cache_size * 1024 * 1024;
+        if (max && gcc_cache_used > max) {
+            gcc_cache_evict(config);
+        }
+    }
+
+    free(tmp_file);
+    free(file);
+}
@@ -368,19 +368,218 @@ void gcc_add_misc_link(
     gcc_add_sanitizers(config, cmd);
 }
 
-/* Compile source file */
+/* Obtain name of dependency file (generated by -MMD) from object file */
 static
-void gcc_compile_src(
+char* gcc_dep_file(
     bake_driver_api *driver,
     bake_config *config,
     bake_project *project,
-    char *source,
-    char *target)
+    const char *obj)
+{
+    /* Add some dummy characters (__) to make room for the extension */
+    char *result = ut_asprintf("%s__", obj);
+    char *ext = strrchr(result, '.');
+    strcpy(ext, ".d");
+    return result;
+}
+
+/* Add compiler and flags used to compile sources and precompiled headers */
+static
+void gcc_add_compile_flags(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    bake_src_lang lang,
+    ut_strbuf *cmd,
+    bool own_source,
+    bool is_pch)
+{
+    ut_strbuf_append(cmd, "%s", cc(lang));
+
+    /* Add misc options */
+    gcc_add_misc(driver, config, project, lang, cmd);
+
+    /* Add optimization flags */
+    gcc_add_optimization(driver, config, project, lang, cmd, is_pch);
+
+    /* Add c/c++ standard arguments */
+    gcc_add_std(driver, config, project, lang, cmd, own_source, is_pch);
+
+    /* Add CFLAGS */
+    gcc_add_flags(driver, config, project, lang, cmd);
+
+    /* Add include directories */
+    gcc_add_includes(driver, config, project, cmd);
+}
+
+/* Obtain name of precompiled header stub. The stub includes the main project
+ * header, and is compiled to <stub>.gch, which the compiler picks up when the
+ * stub is included with -include. */
+static
+char* gcc_pch_file(
+    bake_driver_api *driver,
+    bake_project *project)
+{
+    char *tmp_dir = driver->get_attr_string("tmp-dir");
+    return ut_asprintf("%s/%s/pch/%s.h",
+        project->path, tmp_dir, project->id_underscore);
+}
+
+static
+bake_src_lang gcc_pch_lang(
+    bake_project *project)
+{
+    return is_cpp(project) ? BAKE_SRC_LANG_CPP : BAKE_SRC_LANG_C;
+}
+
+/* Precompile main project header */
+static
+void gcc_build_pch(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project)
 {
+    char *header = ut_asprintf("%s/include/%s.h",
+        project->path, project->id_underscore);
+
+    /* Nothing to precompile if project has no main header */
+    if (ut_file_test(header) != 1) {
+        ut_catch();
+        free(header);
+        return;
+    }
+
+    bake_src_lang lang = gcc_pch_lang(project);
+    char *pch_file = gcc_pch_file(driver, project);
+    char *gch_file = ut_asprintf("%s.gch", pch_file);
+    char *dep_file = ut_asprintf("%s.d", pch_file);
     ut_strbuf cmd = UT_STRBUF_INIT;
-    char *ext = strrchr(source, '.');
-    bool cpp = is_cpp(project);
-    bool file_has_different_language = false;
+
+    gcc_add_compile_flags(driver, config, project, lang, &cmd, true, true);
+
+    ut_strbuf_append(&cmd, " -x %s %s -o %s -MMD -MF %s",
+        lang == BAKE_SRC_LANG_CPP ? "c++-header" : "c-header",
+        pch_file, gch_file, dep_file);
+
+    char *cmdstr = ut_strbuf_get(&cmd);
+
+    if (driver->target_outdated(gch_file, dep_file, cmdstr)) {
+        char *pch_dir = ut_path_dirname(pch_file);
+
+        if (ut_mkdir(pch_dir)) {
+            ut_raise();
+            project->error = true;
+        } else {
+            /* Stub includes header with <>, so that it doesn't include itself
+             * as the header has the same name. The declaration prevents an
+             * empty translation unit error for headers with just macros. */
+            FILE *f = fopen(pch_file, "w");
+            if (!f) {
+                ut_error("failed to open '%s'", pch_file);
+                project->error = true;
+            } else {
+                fprintf(f, "#include <%s.h>\nextern int bake_pch_%s;\n",
+                    project->id_underscore, project->id_underscore);
+                fclose(f);
+
+                /* Don't use outdated header if precompiling fails */
+                if (ut_file_test(gch_file) == 1) {
+                    ut_rm(gch_file);
+                }
+
+                driver->exec(cmdstr);
+
+                if (!project->error) {
+                    driver->target_built(gch_file, cmdstr);
+                }
+            }
+        }
+
+        ut_catch();
+        free(pch_dir);
+    }
+
+    free(cmdstr);
+    free(dep_file);
+    free(gch_file);
+    free(pch_file);
+    free(header);
+}
+
+/* Add precompiled header to command, if it is valid for the source file. The
+ * header is forced into sources with -include, -Winvalid-pch reports when the
+ * compiler can't use the precompiled header and falls back to the stub.
+ * Returns the precompiled header if it was added. */
+static
+char* gcc_add_pch(
+    bake_driver_api *driver,
+    bake_project *project,
+    bake_src_lang lang,
+    bool own_source,
+    ut_strbuf *cmd)
+{
+    if (!own_source || lang != gcc_pch_lang(project)) {
+        return NULL;
+    }
+
+    if (!driver->get_attr_bool("precompile-header")) {
+        return NULL;
+    }
+
+    char *pch_file = gcc_pch_file(driver, project);
+    char *gch_file = ut_asprintf("%s.gch", pch_file);
+
+    if (ut_file_test(gch_file) == 1) {
+        ut_strbuf_append(cmd, " -include %s -Winvalid-pch", pch_file);
+    } else {
+        ut_catch();
+        free(gch_file);
+        gch_file = NULL;
+    }
+
+    free(pch_file);
+
+    return gch_file;
+}
+
+/* Headers loaded from a precompiled header don't show up in the dependency
+ * file, so add the precompiled header itself. This rebuilds the object when
+ * the precompiled header is rebuilt. */
+static
+void gcc_pch_add_dep(
+    const char *dep_file,
+    const char *gch_file)
+{
+    char *deps = ut_file_load(dep_file);
+    if (!deps) {
+        ut_catch();
+        return;
+    }
+
+    if (!strstr(deps, gch_file)) {
+        FILE *f = fopen(dep_file, "a");
+        if (f) {
+            fprintf(f, " %s\n", gch_file);
+            fclose(f);
+        }
+    }
+
+    free(deps);
+}
+
+/* Obtain compiler and flags for source file. Returns the precompiled header
+ * in gch_file_out if it is included in the flags. */
+static
+char* gcc_compile_flags(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    const char *source,
+    bake_src_lang *lang_out,
+    char **gch_file_out)
+{
+    ut_strbuf cmd = UT_STRBUF_INIT;
+    const char *ext = strrchr(source, '.');
     bake_src_lang lang = BAKE_SRC_LANG_C;
 
     if (ext && strcmp(ext, ".c")) {
@@ -389,46 +588,149 @@ void gcc_compile_src(
         } else {
             lang = BAKE_SRC_LANG_CPP;
         }
-
-        file_has_different_language = true;
     }
 
     /* Test if the source file is from the project itself. If the project
      * imports (amalgamated) source files from other projects. */
     bool own_source = true;
-    char *relative_src = &source[strlen(project->path)];
+    const char *relative_src = &source[strlen(project->path)];
     if (!strncmp(relative_src, "deps"UT_OS_PS, 5)) {
         own_source = false;
     }
 
-    ut_strbuf_append(&cmd, "%s", cc(lang));
+    gcc_add_compile_flags(driver, config, project, lang, &cmd, own_source, false);
 
-    /* Add misc options */
-    gcc_add_misc(driver, config, project, lang, &cmd);
-
-    /* Add optimization flags */
-    gcc_add_optimization(driver, config, project, lang, &cmd, false);
+    /* Include precompiled header, if one was built for the project */
+    char *gch_file = gcc_add_pch(driver, project, lang, own_source, &cmd);
+    if (gch_file_out) {
+        *gch_file_out = gch_file;
+    } else {
+        free(gch_file);
+    }
 
-    /* Add c/c++ standard arguments */
-    gcc_add_std(driver, config, project, lang, &cmd, own_source, false);
+    if (lang_out) {
+        *lang_out = lang;
+    }
 
-    /* Add CFLAGS */
-    gcc_add_flags(driver, config, project, lang, &cmd);
+    return ut_strbuf_get(&cmd);
+}
 
-    /* Add include directories */
-    gcc_add_includes(driver, config, project, &cmd);
+/* Append source, object and dependency file to compiler flags */
+static
+char* gcc_compile_cmd_from_flags(
+    bake_config *config,
+    const char *flags,
+    const char *source,
+    const char *target,
+    const char *dep_file)
+{
+    ut_strbuf cmd = UT_STRBUF_INIT;
 
-    /* Add source file and object file */
-    ut_strbuf_append(&cmd, " -c %s", source);
+    ut_strbuf_append(&cmd, "%s -c %s", flags, source);
 
     if (!config->assembly) {
         ut_strbuf_append(&cmd, " -o %s", target);
+
+        /* Generate dependency file with the headers included by the source */
+        ut_strbuf_append(&cmd, " -MMD -MF %s", dep_file);
+    }
+
+    return ut_strbuf_get(&cmd);
+}
+
+/* Obtain command that compiles source file, without compiling it */
+static
+char* gcc_compile_cmd(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    const char *source,
+    const char *target)
+{
+    char *flags = gcc_compile_flags(
+        driver, config, project, source, NULL, NULL);
+    char *dep_file = gcc_dep_file(driver, config, project, target);
+    char *result = gcc_compile_cmd_from_flags(
+        config, flags, source, target, dep_file);
+    free(dep_file);
+    free(flags);
+    return result;
+}
+
+/* Compile source file */
+static
+void gcc_compile_src(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    char *source,
+    char *target)
+{
+    bake_src_lang lang;
+    char *gch_file = NULL;
+    char *flags = gcc_compile_flags(
+        driver, config, project, source, &lang, &gch_file);
+    char *dep_file = gcc_dep_file(driver, config, project, target);
+    char *cache_key = NULL;
+
+    /* If object cache is enabled, preprocess source to find object in cache.
+     * This also generates the dependency file, which is otherwise not created
+     * if the object is found. */
+    if (gcc_cache_enabled(config, project)) {
+        char *pp_file = ut_asprintf("%s.i", target);
+        if (ut_file_test(pp_file) == 1) {
+            ut_rm(pp_file);
+        }
+
+        char *pp_cmd = ut_asprintf("%s -E %s -o %s -MMD -MF %s -MT %s",
+            flags, source, pp_file, dep_file, target);
+        driver->exec(pp_cmd);
+        free(pp_cmd);
+
+        if (!project->error) {
+            cache_key = gcc_cache_key(config, cc(lang), flags, pp_file);
+            if (ut_file_test(pp_file) == 1) {
+                ut_rm(pp_file);
+            }
+        }
+
+        free(pp_file);
+
+        /* Don't compile if preprocessing failed */
+        if (project->error) {
+            goto done;
+        }
+
+        if (cache_key && gcc_cache_get(config, cache_key, target)) {
+            if (gch_file) {
+                gcc_pch_add_dep(dep_file, gch_file);
+            }
+            config->object_cache_hits ++;
+            goto done;
+        }
     }
 
     /* Execute command */
-    char *cmdstr = ut_strbuf_get(&cmd);
+    char *cmdstr = gcc_compile_cmd_from_flags(
+        config, flags, source, target, dep_file);
     driver->exec(cmdstr);
     free(cmdstr);
+
+    if (gch_file && !project->error && !config->assembly) {
+        gcc_pch_add_dep(dep_file, gch_file);
+    }
+
+    /* Add object to cache */
+    if (cache_key && !project->error) {
+        gcc_cache_put(config, cache_key, target);
+        config->object_cache_misses ++;
+    }
+
+done:
+    free(gch_file);
+    free(cache_key);
+    free(dep_file);
+    free(flags);
 }
 
 /* A better mechanism is needed to abstract away from the difference between
@@ -925,7 +1227,19 @@ int gcc_coverage_compare(
     const file_coverage_t *f1 = f1_ptr;
     const file_coverage_t *f2 = f2_ptr;
 
-    return f2->uncovered_lines - f1->uncovered_lines;
+    if (f2->uncovered_lines != f1->uncovered_lines) {
+        return f2->uncovered_lines - f1->uncovered_lines;
+    }
+
+    return strcmp(f1->file, f2->file);
+}
+
+static
+int gcc_coverage_compare_file(
+    const void *f1_ptr,
+    const void *f2_ptr)
+{
+    return strcmp(*(char**)f1_ptr, *(char**)f2_ptr);
 }
 
 static
@@ -948,25 +1262,199 @@ void gcc_print_coverage(
     }
 }
 
+/* Number of gcov processes when bake isn't invoked with -j */
+#define GCC_COVERAGE_JOBS (8)
+
+typedef void (*gcc_coverage_job_cb)(
+    void *ctx,
+    int index);
+
+/* Runs a callback for a range of indices on a pool of threads */
+typedef struct gcc_coverage_pool {
+    gcc_coverage_job_cb action;
+    void *ctx;
+    int count;
+    int next;
+    struct ut_mutex_s lock;
+} gcc_coverage_pool;
+
 static
-void gcc_parse_coverage(
-    bake_project *project,
-    int total_files)
+void* gcc_coverage_worker(
+    gcc_coverage_pool *pool)
 {
-    file_coverage_t *data = malloc(total_files * sizeof(file_coverage_t));
-    char *gcov_dir = ut_asprintf("%s/gcov", project->path);
+    while (true) {
+        ut_mutex_lock(&pool->lock);
+        int index = pool->next ++;
+        ut_mutex_unlock(&pool->lock);
+
+        if (index >= pool->count) {
+            break;
+        }
+
+        pool->action(pool->ctx, index);
+    }
+
+    return NULL;
+}
+
+static
+void gcc_coverage_parallel(
+    bake_config *config,
+    int count,
+    gcc_coverage_job_cb action,
+    void *ctx)
+{
+    gcc_coverage_pool pool = {
+        .action = action,
+        .ctx = ctx,
+        .count = count
+    };
+
+    int i, worker_count = config->jobs > 1 ? config->jobs : GCC_COVERAGE_JOBS;
+    if (worker_count > count) {
+        worker_count = count;
+    }
+
+    ut_mutex_new(&pool.lock);
+
+    ut_thread *workers = ut_calloc(sizeof(ut_thread) * (worker_count + 1));
+    for (i = 0; i < worker_count; i ++) {
+        workers[i] = ut_thread_new((ut_thread_cb)gcc_coverage_worker, &pool);
+    }
+
+    for (i = 0; i < worker_count; i ++) {
+        ut_thread_join(workers[i], NULL);
+    }
+
+    ut_mutex_free(&pool.lock);
+    free(workers);
+}
+
+typedef struct gcc_coverage_ctx {
+    bake_project *project;
+    const char *tmp_dir;
+    char **files;
+    int8_t *failed;
+    file_coverage_t *data;
+} gcc_coverage_ctx;
+
+static
+char* gcc_coverage_gcov_cmd(
+    const char *tmp_dir,
+    const char *file)
+{
+    ut_strbuf cmd = UT_STRBUF_INIT;
+    ut_strbuf_append(&cmd, "gcov --object-file %s/obj/%s %s/obj/%s", tmp_dir, file, tmp_dir, file);
+    return ut_strbuf_get(&cmd);
+}
+
+/* Directory in which the gcov invocation for a single source file runs */
+static
+char* gcc_coverage_job_dir(
+    const char *tmp_dir,
+    int index)
+{
+    return ut_asprintf("%s"UT_OS_PS"gcov"UT_OS_PS"%d", tmp_dir, index);
+}
+
+static
+void gcc_coverage_run_gcov(
+    void *ptr,
+    int index)
+{
+    gcc_coverage_ctx *ctx = ptr;
+    char *job_dir = gcc_coverage_job_dir(ctx->tmp_dir, index);
+    char *obj_file = ut_asprintf("../../obj/%s", ctx->files[index]);
+
+    ctx->failed[index] = 1;
+
+    if (ut_mkdir(job_dir)) {
+        ut_catch();
+        goto done;
+    }
+
+    /* gcov writes to the working directory, which is shared by all threads,
+     * so let a shell enter the job directory first. Paths are passed as
+     * arguments so they don't need to be quoted. */
+    ut_proc pid = ut_proc_runRedirect("sh", (const char*[]){
+        "sh", "-c", "cd \"$0\" && exec gcov --object-file \"$1\" \"$1\"",
+        job_dir, obj_file, NULL
+    }, stdin, NULL, stderr);
+
+    if (pid) {
+        int8_t rc;
+        int sig = ut_proc_wait(pid, &rc);
+        ctx->failed[index] = sig || rc;
+    }
+
+done:
+    free(obj_file);
+    free(job_dir);
+}
+
+static
+void gcc_coverage_parse_gcov(
+    void *ptr,
+    int index)
+{
+    gcc_coverage_ctx *ctx = ptr;
+    ctx->data[index] = gcc_parse_gcov(ctx->project, ctx->files[index]);
+}
+
+/* Collect files in directory, sorted so results don't depend on the order in
+ * which files are listed */
+static
+char** gcc_coverage_files(
+    const char *dir,
+    const char *filter,
+    int *count_out)
+{
+    char **files = NULL;
+    int count = 0;
 
     ut_iter it;
-    ut_dir_iter(gcov_dir, "*.gcov", &it);
-    int i = 0, file_len_max = 0;
+    if (ut_dir_iter(dir, filter, &it)) {
+        ut_catch();
+        *count_out = 0;
+        return NULL;
+    }
+
+    while (ut_iter_hasNext(&it)) {
+        files = realloc(files, (count + 1) * sizeof(char*));
+        files[count ++] = ut_strdup(ut_iter_next(&it));
+    }
+
+    if (count) {
+        qsort(files, count, sizeof(char*), gcc_coverage_compare_file);
+    }
+
+    *count_out = count;
+    return files;
+}
+
+static
+void gcc_coverage_free_files(
+    char **files,
+    int count)
+{
+    int i;
+    for (i = 0; i < count; i ++) {
+        free(files[i]);
+    }
+    free(files);
+}
+
+static
+void gcc_report_coverage(
+    file_coverage_t *data,
+    int total_files)
+{
+    int i, file_len_max = 0;
     int total_lines = 0;
     int uncovered_lines = 0;
     float coverage = 0;
 
-    while (ut_iter_hasNext(&it)) {
-        char *file = ut_iter_next(&it);
-        data[i] = gcc_parse_gcov(project, file);
-        
+    for (i = 0; i < total_files; i ++) {
         int file_len = strlen(data[i].file);
         if (file_len > file_len_max) {
             file_len_max = file_len;
@@ -974,8 +1462,6 @@ void gcc_parse_coverage(
 
         total_lines += data[i].total_lines;
         uncovered_lines += data[i].uncovered_lines;
-
-        i ++;
     }
 
     qsort(data, total_files, sizeof(file_coverage_t), gcc_coverage_compare);
@@ -992,98 +1478,216 @@ void gcc_parse_coverage(
     coverage = 100.0 * (1.0 - (float)uncovered_lines / total_lines);
     gcc_print_coverage("total", file_len_max, coverage, total_lines, uncovered_lines);
     printf("\n");
+}
+
+static
+void gcc_parse_coverage(
+    bake_config *config,
+    bake_project *project,
+    char **files,
+    int total_files)
+{
+    file_coverage_t *data = malloc(total_files * sizeof(file_coverage_t));
+
+    gcc_coverage_ctx ctx = {
+        .project = project,
+        .files = files,
+        .data = data
+    };
+
+    gcc_coverage_parallel(
+        config, total_files, gcc_coverage_parse_gcov, &ctx);
+
+    gcc_report_coverage(data, total_files);
 
-    free(gcov_dir);
     free(data);
 }
 
+static
+char* gcc_coverage_obj_file(
+    const char *tmp_dir,
+    const char *file,
+    const char *ext)
+{
+    /* Add some dummy characters (__) to make room for the extension */
+    char *result = ut_asprintf("%s/obj/%s__", tmp_dir, file);
+    strcpy(strrchr(result, '.'), ext);
+    return result;
+}
+
+static
+void gcc_coverage_read_native(
+    void *ptr,
+    int index)
+{
+    gcc_coverage_ctx *ctx = ptr;
+    const char *file = ctx->files[index];
+    char *notes_file = gcc_coverage_obj_file(ctx->tmp_dir, file, ".gcno");
+    char *data_file = gcc_coverage_obj_file(ctx->tmp_dir, file, ".gcda");
+    file_coverage_t *data = &ctx->data[index];
+
+    data->file = NULL;
+
+    if (gcc_gcov_read(notes_file, data_file, file,
+        &data->total_lines, &data->uncovered_lines))
+    {
+        ctx->failed[index] = 1;
+    } else {
+        data->file = ut_strdup(file);
+    }
+
+    free(notes_file);
+    free(data_file);
+}
+
+/* Compute coverage from notes and data files without running gcov. Returns
+ * -1 if one of the files could not be read. */
+static
+int16_t gcc_coverage_native(
+    bake_config *config,
+    bake_project *project,
+    const char *tmp_dir,
+    char **files,
+    int total_files)
+{
+    file_coverage_t *data = malloc(total_files * sizeof(file_coverage_t));
+    int i, result = 0;
+
+    gcc_coverage_ctx ctx = {
+        .project = project,
+        .tmp_dir = tmp_dir,
+        .files = files,
+        .failed = ut_calloc(total_files * sizeof(int8_t)),
+        .data = data
+    };
+
+    gcc_coverage_parallel(
+        config, total_files, gcc_coverage_read_native, &ctx);
+
+    for (i = 0; i < total_files; i ++) {
+        if (ctx.failed[i]) {
+            result = -1;
+        }
+    }
+
+    if (!result) {
+        gcc_report_coverage(data, total_files);
+    } else {
+        for (i = 0; i < total_files; i ++) {
+            free(data[i].file);
+        }
+    }
+
+    free(ctx.failed);
+    free(data);
+
+    return result;
+}
+
 static
 void gcc_coverage(
     bake_driver_api *driver,
     bake_config *config,
     bake_project *project)
 {
-    int total_files = 0;
+    int i, total_files = 0, total_gcov_files = 0;
+    char **gcov_files = NULL;
 
     char *tmp_dir = driver->get_attr_string("tmp-dir");
 
-    ut_iter it;
     char *src_dir = ut_asprintf("%s/src", project->path);
-    ut_dir_iter(src_dir, "//*.c,*.cpp", &it);
+    char **files = gcc_coverage_files(src_dir, "//*.c,*.cpp", &total_files);
     free(src_dir);
 
-    while (ut_iter_hasNext(&it)) {
-        char *file = ut_iter_next(&it);
-        ut_strbuf cmd = UT_STRBUF_INIT;
-        ut_strbuf_append(&cmd, "gcov --object-file %s/obj/%s %s/obj/%s", tmp_dir, file, tmp_dir, file);
-        char *cmdstr = ut_strbuf_get(&cmd);
+    if (!total_files) {
+        ut_error("no source files to analyze for coverage report");
+        project->error = true;
+        return;
+    }
 
-        int8_t rc;
-        int sig = ut_proc_cmd_stderr_only(cmdstr, &rc);
-        if (sig || rc) {
-            ut_error("failed to run gcov command '%s'", cmdstr);
-            project->error = 1;
-            return;
-        }
+    if (!gcc_coverage_native(config, project, tmp_dir, files, total_files)) {
+        gcc_coverage_free_files(files, total_files);
+        return;
+    }
 
-        free(cmdstr);
+    ut_trace("#[grey]cannot read coverage files directly, running gcov");
+
+    /* Run gcov for all source files in parallel. Each invocation writes the
+     * .gcov files for its source and the headers it includes to its own job
+     * directory, so invocations that include the same header don't write to
+     * the same file. */
+    char *job_root = ut_asprintf("%s"UT_OS_PS"gcov", tmp_dir);
+    char *gcov_dir = ut_asprintf("%s"UT_OS_PS"gcov", project->path);
+
+    gcc_coverage_ctx ctx = {
+        .project = project,
+        .tmp_dir = tmp_dir,
+        .files = files,
+        .failed = ut_calloc(total_files * sizeof(int8_t))
+    };
 
-        total_files ++;
+    ut_rm(job_root);
+    if (ut_mkdir(job_root)) {
+        ut_error("failed to create gcov directory '%s'", job_root);
+        project->error = 1;
+        goto done;
     }
 
-    if (!total_files) {
-        ut_error("no source files to analyze for coverage report");
-        project->error = true;
-        return;
+    gcc_coverage_parallel(config, total_files, gcc_coverage_run_gcov, &ctx);
+
+    for (i = 0; i < total_files; i ++) {
+        if (ctx.failed[i]) {
+            char *cmdstr = gcc_coverage_gcov_cmd(tmp_dir, files[i]);
+            ut_error("failed to run gcov command '%s'", cmdstr);
+            free(cmdstr);
+            project->error = 1;
+            goto done;
+        }
     }
 
-    char *gcov_dir = ut_asprintf("%s/gcov", project->path);
     ut_rm(gcov_dir);
     
     if (ut_mkdir(gcov_dir)) {
         ut_error("failed to create gcov directory '%s'", gcov_dir);
         project->error = 1;
-        free(gcov_dir);
-        return;
+        goto done;
     }
-    free(gcov_dir);
-
-    ut_dir_iter(project->path, "*.gcov", &it);
-    int total_gcov_files = 0;
 
-    while (ut_iter_hasNext(&it)) {
-        char *file = ut_iter_next(&it);
-        char *dst_file = ut_asprintf("gcov/%s", file);
+    /* Merge the .gcov file of each source into the gcov directory. Headers
+     * are not reported, like when coverage is read from the data files. */
+    gcov_files = ut_calloc(total_files * sizeof(char*));
 
-        if (ut_rename(file, dst_file)) {
-            ut_error(
-                "failed to move file '%s'", 
-                file);
+    for (i = 0; i < total_files; i ++) {
+        char *job_dir = gcc_coverage_job_dir(tmp_dir, i);
+        const char *name = strrchr(files[i], '/');
+        name = name ? name + 1 : files[i];
+
+        char *src_file = ut_asprintf("%s"UT_OS_PS"%s.gcov", job_dir, name);
+        char *dst_file = ut_asprintf("%s"UT_OS_PS"%s.gcov", gcov_dir, name);
+        free(job_dir);
+
+        if (ut_rename(src_file, dst_file)) {
+            ut_error("no gcov file for source file '%s'", files[i]);
+            free(src_file);
+            free(dst_file);
+            project->error = 1;
+            goto done;
         }
 
+        gcov_files[total_gcov_files ++] = ut_asprintf("%s.gcov", name);
+        free(src_file);
         free(dst_file);
-        total_gcov_files ++;
     }
 
-    if (!total_gcov_files) {
-        ut_error("no gcov files");
-        project->error = true;
-        return;
-    }
-
-    if (total_gcov_files < total_files) {
-        ut_error("found %d source files, but only %d gcov files",
-            total_files, total_gcov_files);
-        project->error = true;
-        return;
-    } else if (total_gcov_files > total_files) {
-        ut_error("found %d gcov files, but only %d source files",
-            total_files, total_gcov_files);
-        project->error = true;
-        return;
-    }
+    gcc_parse_coverage(config, project, gcov_files, total_gcov_files);
 
-    gcc_parse_coverage(project, total_files);
+done:
+    ut_rm(job_root);
+    gcc_coverage_free_files(gcov_files, total_gcov_files);
+    gcc_coverage_free_files(files, total_files);
+    free(ctx.failed);
+    free(gcov_dir);
+    free(job_root);
 }
 
 static
@@ -1118,11 +1722,14 @@ static
 bake_compiler_interface gcc_get() {
     bake_compiler_interface result = {
         .compile = gcc_compile_src,
+        .compile_cmd = gcc_compile_cmd,
+        .build_pch = gcc_build_pch,
         .link = gcc_link_binary,
         .clean_coverage = gcc_clean_coverage,
         .coverage = gcc_coverage,
         .artefact_name = gcc_artefact_name,
-        .link_to_lib = gcc_link_to_lib
+        .link_to_lib = gcc_link_to_lib,
+        .dep_file = gcc_dep_file
     };
 
     return result;
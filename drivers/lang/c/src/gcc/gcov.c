@@ -0,0 +1,605 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Reader for the notes (.gcno) and data (.gcda) files that gcc generates for
+ * coverage, so line coverage can be computed without running gcov. The notes
+ * file describes the flow graph of each function, and which source lines
+ * belong to which basic block. The data file contains execution counts for
+ * the arcs of the flow graph that are not on its spanning tree, from which the
+ * counts of the other arcs and of the blocks are derived.
+ *
+ * Only the format of gcc 12 and later is supported, which stores lengths in
+ * bytes. For other formats the reader returns an error, and the driver falls
+ * back to running gcov. */
+
+#define GCC_GCOV_NOTE_MAGIC (0x67636e6f) /* "gcno" */
+#define GCC_GCOV_DATA_MAGIC (0x67636461) /* "gcda" */
+
+#define GCC_GCOV_TAG_FUNCTION (0x01000000)
+#define GCC_GCOV_TAG_BLOCKS (0x01410000)
+#define GCC_GCOV_TAG_ARCS (0x01430000)
+#define GCC_GCOV_TAG_LINES (0x01450000)
+#define GCC_GCOV_TAG_ARC_COUNTS (0x01a10000)
+
+#define GCC_GCOV_ARC_ON_TREE (1)
+
+typedef struct gcc_gcov_buffer {
+    unsigned char *data;
+    size_t size;
+    size_t pos;
+    bool error;
+} gcc_gcov_buffer;
+
+typedef struct gcc_gcov_arc {
+    uint32_t src;
+    uint32_t dst;
+    bool on_tree;
+    bool known;
+    uint64_t count;
+} gcc_gcov_arc;
+
+typedef struct gcc_gcov_line {
+    uint32_t block;
+    uint32_t line;
+} gcc_gcov_line;
+
+typedef struct gcc_gcov_function {
+    uint32_t ident;
+    uint32_t block_count;
+    gcc_gcov_arc *arcs;
+    uint32_t arc_count;
+    gcc_gcov_line *lines;    /* Lines of the source file in function */
+    uint32_t line_count;
+} gcc_gcov_function;
+
+typedef struct gcc_gcov_object {
+    gcc_gcov_function *functions;
+    uint32_t function_count;
+} gcc_gcov_object;
+
+static
+int16_t gcc_gcov_load(
+    const char *file,
+    gcc_gcov_buffer *buf)
+{
+    FILE *f = fopen(file, "rb");
+    if (!f) {
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    rewind(f);
+
+    if (size <= 0) {
+        fclose(f);
+        return -1;
+    }
+
+    buf->data = malloc(size);
+    buf->size = fread(buf->data, 1, size, f);
+    buf->pos = 0;
+    buf->error = buf->size != (size_t)size;
+
+    fclose(f);
+
+    return buf->error ? -1 : 0;
+}
+
+static
+uint32_t gcc_gcov_read_u32(
+    gcc_gcov_buffer *buf)
+{
+    uint32_t result;
+
+    if (buf->pos + 4 > buf->size) {
+        buf->error = true;
+        buf->pos = buf->size;
+        return 0;
+    }
+
+    memcpy(&result, &buf->data[buf->pos], 4);
+    buf->pos += 4;
+
+    return result;
+}
+
+static
+uint64_t gcc_gcov_read_u64(
+    gcc_gcov_buffer *buf)
+{
+    uint64_t low = gcc_gcov_read_u32(buf);
+    uint64_t high = gcc_gcov_read_u32(buf);
+    return low | (high << 32);
+}
+
+/* Strings are stored as a length in bytes (including the terminator),
+ * followed by the characters. Returns NULL for the empty string. */
+static
+const char* gcc_gcov_read_str(
+    gcc_gcov_buffer *buf)
+{
+    uint32_t len = gcc_gcov_read_u32(buf);
+    if (!len) {
+        return NULL;
+    }
+
+    if (buf->pos + len > buf->size || buf->data[buf->pos + len - 1]) {
+        buf->error = true;
+        buf->pos = buf->size;
+        return NULL;
+    }
+
+    const char *result = (const char*)&buf->data[buf->pos];
+    buf->pos += len;
+
+    return result;
+}
+
+/* Read file header. Returns the stamp, which is the same for notes and data
+ * files generated by the same compilation. */
+static
+int16_t gcc_gcov_read_header(
+    gcc_gcov_buffer *buf,
+    uint32_t magic,
+    uint32_t *stamp_out)
+{
+    if (gcc_gcov_read_u32(buf) != magic) {
+        return -1;
+    }
+
+    /* Version is encoded as the tens of the major as a letter ('A' is 0, 'B'
+     * is 1), the units of the major as a digit, the minor and a status
+     * character. Record lengths are only in bytes from gcc 12 onwards. */
+    uint32_t version = gcc_gcov_read_u32(buf);
+    char tens = (char)(version >> 24), units = (char)(version >> 16);
+    if (tens < 'B' || tens > 'Z' || (tens == 'B' && units < '2')) {
+        return -1;
+    }
+
+    *stamp_out = gcc_gcov_read_u32(buf);
+    gcc_gcov_read_u32(buf); /* checksum */
+
+    return buf->error ? -1 : 0;
+}
+
+/* Test if file name in notes file refers to source file in src directory */
+static
+bool gcc_gcov_is_source(
+    const char *name,
+    const char *source)
+{
+    size_t name_len = strlen(name), source_len = strlen(source);
+    if (name_len < source_len + 4) {
+        return false;
+    }
+
+    const char *tail = &name[name_len - source_len];
+    const char *dir = tail - 4;
+    if (strcmp(tail, source) || (tail[-1] != '/' && tail[-1] != '\\')) {
+        return false;
+    }
+
+    if (strncmp(dir, "src", 3)) {
+        return false;
+    }
+
+    return dir == name || dir[-1] == '/' || dir[-1] == '\\';
+}
+
+static
+void gcc_gcov_read_lines(
+    gcc_gcov_buffer *buf,
+    gcc_gcov_function *function,
+    const char *source,
+    size_t end)
+{
+    uint32_t block = gcc_gcov_read_u32(buf);
+    bool in_source = false;
+
+    while (buf->pos < end && !buf->error) {
+        uint32_t line = gcc_gcov_read_u32(buf);
+        if (!line) {
+            const char *name = gcc_gcov_read_str(buf);
+            if (!name) {
+                break;
+            }
+            in_source = gcc_gcov_is_source(name, source);
+        } else if (in_source) {
+            function->lines = realloc(function->lines,
+                (function->line_count + 1) * sizeof(gcc_gcov_line));
+            function->lines[function->line_count].block = block;
+            function->lines[function->line_count].line = line;
+            function->line_count ++;
+        }
+    }
+}
+
+static
+int16_t gcc_gcov_read_notes(
+    const char *file,
+    const char *source,
+    gcc_gcov_object *object,
+    uint32_t *stamp_out)
+{
+    gcc_gcov_buffer buf = {0};
+    gcc_gcov_function *function = NULL;
+
+    if (gcc_gcov_load(file, &buf)) {
+        goto error;
+    }
+
+    if (gcc_gcov_read_header(&buf, GCC_GCOV_NOTE_MAGIC, stamp_out)) {
+        goto error;
+    }
+
+    gcc_gcov_read_str(&buf); /* working directory */
+    gcc_gcov_read_u32(&buf); /* has unexecuted blocks */
+
+    while (buf.pos < buf.size && !buf.error) {
+        uint32_t tag = gcc_gcov_read_u32(&buf);
+        uint32_t length = gcc_gcov_read_u32(&buf);
+        size_t end = buf.pos + length;
+
+        if (end > buf.size) {
+            goto error;
+        }
+
+        if (tag == GCC_GCOV_TAG_FUNCTION) {
+            object->functions = realloc(object->functions,
+                (object->function_count + 1) * sizeof(gcc_gcov_function));
+            function = &object->functions[object->function_count ++];
+            memset(function, 0, sizeof(gcc_gcov_function));
+            function->ident = gcc_gcov_read_u32(&buf);
+        } else if (!function) {
+            /* Records other than functions are part of a function */
+        } else if (tag == GCC_GCOV_TAG_BLOCKS) {
+            function->block_count = gcc_gcov_read_u32(&buf);
+        } else if (tag == GCC_GCOV_TAG_ARCS) {
+            uint32_t i, src = gcc_gcov_read_u32(&buf);
+            uint32_t count = (length - 4) / 8;
+
+            function->arcs = realloc(function->arcs,
+                (function->arc_count + count) * sizeof(gcc_gcov_arc));
+
+            for (i = 0; i < count; i ++) {
+                gcc_gcov_arc *arc = &function->arcs[function->arc_count ++];
+                memset(arc, 0, sizeof(gcc_gcov_arc));
+                arc->src = src;
+                arc->dst = gcc_gcov_read_u32(&buf);
+                arc->on_tree = gcc_gcov_read_u32(&buf) & GCC_GCOV_ARC_ON_TREE;
+                if (arc->src >= function->block_count ||
+                    arc->dst >= function->block_count)
+                {
+                    goto error;
+                }
+            }
+        } else if (tag == GCC_GCOV_TAG_LINES) {
+            gcc_gcov_read_lines(&buf, function, source, end);
+        }
+
+        buf.pos = end;
+    }
+
+    if (buf.error) {
+        goto error;
+    }
+
+    free(buf.data);
+    return 0;
+error:
+    free(buf.data);
+    return -1;
+}
+
+/* Add counts of arcs that are not on the spanning tree. A missing data file
+ * means that the object was never executed. */
+static
+int16_t gcc_gcov_read_data(
+    const char *file,
+    gcc_gcov_object *object,
+    uint32_t stamp)
+{
+    gcc_gcov_buffer buf = {0};
+    gcc_gcov_function *function = NULL;
+    uint32_t data_stamp;
+
+    if (gcc_gcov_load(file, &buf)) {
+        free(buf.data);
+        return 0;
+    }
+
+    if (gcc_gcov_read_header(&buf, GCC_GCOV_DATA_MAGIC, &data_stamp)) {
+        goto error;
+    }
+
+    /* Data is from a different compilation of the source */
+    if (data_stamp != stamp) {
+        ut_trace("#[grey]ignoring '%s' (stamp mismatch)", file);
+        free(buf.data);
+        return 0;
+    }
+
+    while (buf.pos < buf.size && !buf.error) {
+        uint32_t tag = gcc_gcov_read_u32(&buf);
+        if (!tag) {
+            break; /* End of file */
+        }
+
+        int32_t length = (int32_t)gcc_gcov_read_u32(&buf);
+
+        /* A negative length indicates that all counters are zero */
+        if (length < 0) {
+            continue;
+        }
+
+        size_t end = buf.pos + length;
+        if (end > buf.size) {
+            goto error;
+        }
+
+        if (tag == GCC_GCOV_TAG_FUNCTION) {
+            uint32_t i, ident = length ? gcc_gcov_read_u32(&buf) : 0;
+            function = NULL;
+            for (i = 0; i < object->function_count; i ++) {
+                if (object->functions[i].ident == ident) {
+                    function = &object->functions[i];
+                    break;
+                }
+            }
+        } else if (tag == GCC_GCOV_TAG_ARC_COUNTS && function) {
+            uint32_t i, count = length / 8;
+            for (i = 0; i < function->arc_count && count; i ++) {
+                gcc_gcov_arc *arc = &function->arcs[i];
+                if (!arc->on_tree) {
+                    arc->count += gcc_gcov_read_u64(&buf);
+                    count --;
+                }
+            }
+        }
+
+        buf.pos = end;
+    }
+
+    if (buf.error) {
+        goto error;
+    }
+
+    free(buf.data);
+    return 0;
+error:
+    free(buf.data);
+    return -1;
+}
+
+/* Arcs of a block, as indices into the arcs of a function */
+typedef struct gcc_gcov_block_arcs {
+    uint32_t *arcs;
+    uint32_t count;
+} gcc_gcov_block_arcs;
+
+/* Sum counts of arcs. Returns the number of arcs with unknown counts, and sets
+ * unknown_out to the unknown arc if there is only one. */
+static
+uint32_t gcc_gcov_sum_arcs(
+    gcc_gcov_function *function,
+    gcc_gcov_block_arcs *arcs,
+    uint64_t *sum_out,
+    gcc_gcov_arc **unknown_out)
+{
+    uint32_t i, unknown = 0;
+    uint64_t sum = 0;
+
+    *unknown_out = NULL;
+
+    for (i = 0; i < arcs->count; i ++) {
+        gcc_gcov_arc *arc = &function->arcs[arcs->arcs[i]];
+        if (arc->known) {
+            sum += arc->count;
+        } else {
+            *unknown_out = arc;
+            unknown ++;
+        }
+    }
+
+    if (unknown != 1) {
+        *unknown_out = NULL;
+    }
+
+    *sum_out = sum;
+
+    return unknown;
+}
+
+static
+void gcc_gcov_add_block_arc(
+    gcc_gcov_block_arcs *arcs,
+    uint32_t arc)
+{
+    arcs->arcs = realloc(arcs->arcs, (arcs->count + 1) * sizeof(uint32_t));
+    arcs->arcs[arcs->count ++] = arc;
+}
+
+/* Derive block counts from arc counts. Counts of arcs on the spanning tree
+ * follow from the fact that a block is entered as often as it is left. */
+static
+void gcc_gcov_solve(
+    gcc_gcov_function *function,
+    uint64_t *counts)
+{
+    uint32_t i, block_count = function->block_count;
+    bool *known = ut_calloc(block_count * sizeof(bool));
+    gcc_gcov_block_arcs *in = ut_calloc(
+        block_count * sizeof(gcc_gcov_block_arcs));
+    gcc_gcov_block_arcs *out = ut_calloc(
+        block_count * sizeof(gcc_gcov_block_arcs));
+    bool progress = true;
+
+    for (i = 0; i < function->arc_count; i ++) {
+        gcc_gcov_arc *arc = &function->arcs[i];
+        arc->known = !arc->on_tree;
+        gcc_gcov_add_block_arc(&out[arc->src], i);
+        gcc_gcov_add_block_arc(&in[arc->dst], i);
+    }
+
+    while (progress) {
+        progress = false;
+
+        for (i = 0; i < block_count; i ++) {
+            gcc_gcov_arc *unknown_in, *unknown_out;
+            uint64_t sum_in, sum_out;
+
+            uint32_t in_unknown = gcc_gcov_sum_arcs(
+                function, &in[i], &sum_in, &unknown_in);
+            uint32_t out_unknown = gcc_gcov_sum_arcs(
+                function, &out[i], &sum_out, &unknown_out);
+
+            if (!known[i]) {
+                if (out[i].count && !out_unknown) {
+                    counts[i] = sum_out;
+                    known[i] = true;
+                } else if (in[i].count && !in_unknown) {
+                    counts[i] = sum_in;
+                    known[i] = true;
+                } else if (!in[i].count && !out[i].count) {
+                    counts[i] = 0;
+                    known[i] = true;
+                }
+
+                if (known[i]) {
+                    progress = true;
+                }
+            }
+
+            if (known[i]) {
+                if (unknown_out) {
+                    unknown_out->count =
+                        counts[i] > sum_out ? counts[i] - sum_out : 0;
+                    unknown_out->known = true;
+                    progress = true;
+                }
+                if (unknown_in) {
+                    unknown_in->count =
+                        counts[i] > sum_in ? counts[i] - sum_in : 0;
+                    unknown_in->known = true;
+                    progress = true;
+                }
+            }
+        }
+    }
+
+    for (i = 0; i < block_count; i ++) {
+        free(in[i].arcs);
+        free(out[i].arcs);
+    }
+
+    free(in);
+    free(out);
+    free(known);
+}
+
+static
+void gcc_gcov_object_free(
+    gcc_gcov_object *object)
+{
+    uint32_t i;
+    for (i = 0; i < object->function_count; i ++) {
+        free(object->functions[i].arcs);
+        free(object->functions[i].lines);
+    }
+    free(object->functions);
+}
+
+/* Compute line coverage of source file from notes and data files. Source is
+ * the path of the file relative to the src directory. Returns -1 if the files
+ * can't be read, or have an unsupported format. */
+static
+int16_t gcc_gcov_read(
+    const char *notes_file,
+    const char *data_file,
+    const char *source,
+    int *total_lines_out,
+    int *uncovered_lines_out)
+{
+    gcc_gcov_object object = {0};
+    uint32_t stamp, i, l, line_max = 0;
+
+    if (gcc_gcov_read_notes(notes_file, source, &object, &stamp)) {
+        goto error;
+    }
+
+    if (gcc_gcov_read_data(data_file, &object, stamp)) {
+        goto error;
+    }
+
+    for (i = 0; i < object.function_count; i ++) {
+        gcc_gcov_function *function = &object.functions[i];
+        for (l = 0; l < function->line_count; l ++) {
+            if (function->lines[l].line > line_max) {
+                line_max = function->lines[l].line;
+            }
+        }
+    }
+
+    /* 0 = no code, 1 = not executed, 2 = executed */
+    uint8_t *lines = ut_calloc(line_max + 1);
+
+    for (i = 0; i < object.function_count; i ++) {
+        gcc_gcov_function *function = &object.functions[i];
+        uint64_t *counts = ut_calloc(
+            (function->block_count + 1) * sizeof(uint64_t));
+
+        gcc_gcov_solve(function, counts);
+
+        for (l = 0; l < function->line_count; l ++) {
+            gcc_gcov_line *line = &function->lines[l];
+            if (line->block >= function->block_count) {
+                continue;
+            }
+            if (counts[line->block]) {
+                lines[line->line] = 2;
+            } else if (!lines[line->line]) {
+                lines[line->line] = 1;
+            }
+        }
+
+        free(counts);
+    }
+
+    *total_lines_out = 0;
+    *uncovered_lines_out = 0;
+
+    for (l = 1; l <= line_max; l ++) {
+        if (lines[l]) {
+            (*total_lines_out) ++;
+            if (lines[l] == 1) {
+                (*uncovered_lines_out) ++;
+            }
+        }
+    }
+
+    free(lines);
+    gcc_gcov_object_free(&object);
+    return 0;
+error:
+    gcc_gcov_object_free(&object);
+    return -1;
+}
@@ -31,12 +31,15 @@ typedef enum bake_src_lang {
 
 typedef struct bake_compiler_interface {
     bake_rule_action_cb compile;
+    bake_rule_command_cb compile_cmd;
     bake_rule_action_cb link;
+    bake_driver_cb build_pch;
     bake_driver_cb clean_coverage;
     bake_driver_cb coverage;
     bake_driver_cb clean;
     bake_artefact_cb artefact_name;
     bake_link_to_lib_cb link_to_lib;
+    bake_rule_map_cb dep_file;
 } bake_compiler_interface;
 
 static bake_compiler_interface cif;
@@ -229,8 +232,430 @@ char* obj_ext() {
 
 
 #include "msvc/driver.c"
+#include "gcc/cache.c"
+#include "gcc/gcov.c"
 #include "gcc/driver.c"
 
+/* Pattern that matches source files */
+static
+const char* sources_pattern(
+    bake_config *config)
+{
+    if (!strcmp(config->build_os, "Darwin")) {
+        return "//*.c|*.cpp|*.cxx|*.m|*.mm";
+    } else {
+        return "//*.c|*.cpp|*.cxx";
+    }
+}
+
+/* -- Unity builds */
+
+/* Number of sources per unity translation unit if "unity" is set to true */
+#define UNITY_BATCH_SIZE (8)
+
+typedef struct unity_batch {
+    const char *ext;
+    char **files;
+    uint32_t count;
+} unity_batch;
+
+/* Number of sources per unity translation unit, 0 if unity builds are off */
+static
+uint32_t unity_batch_size(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project)
+{
+    bake_attr *attr = driver->get_attr("unity");
+    if (!attr) {
+        return 0;
+    }
+
+    /* Coverage is reported per source file, so don't combine sources */
+    if (config->coverage && project->coverage) {
+        return 0;
+    }
+
+    if (attr->kind == BAKE_BOOLEAN) {
+        return attr->is.boolean ? UNITY_BATCH_SIZE : 0;
+    } else if (attr->kind == BAKE_NUMBER && attr->is.number >= 1) {
+        return attr->is.number;
+    }
+
+    return 0;
+}
+
+static
+bool unity_enabled(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project)
+{
+    return unity_batch_size(driver, config, project) != 0;
+}
+
+/* Test if source opted out of unity build with "unity-exclude" */
+static
+bool unity_excluded(
+    bake_driver_api *driver,
+    const char *file)
+{
+    bake_attr *attr = driver->get_attr("unity-exclude");
+    if (attr && attr->kind == BAKE_ARRAY) {
+        ut_iter it = ut_ll_iter(attr->is.array);
+        while (ut_iter_hasNext(&it)) {
+            bake_attr *elem = ut_iter_next(&it);
+            if (elem->kind == BAKE_STRING && ut_expr(elem->is.string, file)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* Path of source in project, which is used to identify unity sources */
+static
+char* unity_source_path(
+    bake_project *project,
+    const char *src,
+    const char *file)
+{
+    char *result = ut_asprintf(
+        "%s"UT_OS_PS"%s"UT_OS_PS"%s", project->path, src, file);
+    ut_path_clean(result, result);
+    return result;
+}
+
+static
+bool unity_has_source(
+    bake_attr *attr,
+    const char *path)
+{
+    ut_iter it = ut_ll_iter(attr->is.array);
+    while (ut_iter_hasNext(&it)) {
+        bake_attr *elem = ut_iter_next(&it);
+        if (!strcmp(elem->is.string, path)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Test if source is compiled as part of a unity source. The input of the map
+ * is relative to its source directory, so test it for each directory. Sources
+ * with a name that occurs in multiple directories are never combined. */
+static
+bool unity_contains(
+    bake_driver_api *driver,
+    bake_project *project,
+    const char *file)
+{
+    bake_attr *attr = driver->get_attr("unity-sources");
+    bool result = false;
+
+    if (!attr || attr->kind != BAKE_ARRAY) {
+        return false;
+    }
+
+    ut_iter it = ut_ll_iter(project->sources);
+    while (!result && ut_iter_hasNext(&it)) {
+        char *path = unity_source_path(project, ut_iter_next(&it), file);
+        result = unity_has_source(attr, path);
+        free(path);
+    }
+
+    return result;
+}
+
+/* Sources may have been added, removed or excluded since the last build */
+static
+void unity_reset_sources(
+    bake_driver_api *driver)
+{
+    bake_attr *attr = driver->get_attr("unity-sources");
+    if (attr && attr->kind == BAKE_ARRAY) {
+        ut_iter it = ut_ll_iter(attr->is.array);
+        while (ut_iter_hasNext(&it)) {
+            bake_attr *elem = ut_iter_next(&it);
+            free(elem->is.string);
+            free(elem);
+        }
+        ut_ll_clear(attr->is.array);
+    }
+}
+
+/* Test if a source with the same name exists in another source directory */
+static
+bool unity_is_ambiguous(
+    bake_project *project,
+    const char *src,
+    const char *file)
+{
+    bool result = false;
+
+    ut_iter it = ut_ll_iter(project->sources);
+    while (!result && ut_iter_hasNext(&it)) {
+        char *other = ut_iter_next(&it);
+        if (strcmp(other, src)) {
+            char *path = unity_source_path(project, other, file);
+            result = ut_file_test(path) == 1;
+            free(path);
+        }
+    }
+
+    ut_catch();
+
+    return result;
+}
+
+static
+int unity_compare(
+    const void *f1,
+    const void *f2)
+{
+    return strcmp(*(char**)f1, *(char**)f2);
+}
+
+/* Collect project sources that can be combined into unity sources. Sources
+ * imported from other projects (in deps) are compiled with different flags. */
+static
+int16_t unity_collect(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    unity_batch *c_files,
+    unity_batch *cpp_files)
+{
+    unity_reset_sources(driver);
+
+    ut_iter it = ut_ll_iter(project->sources);
+    while (ut_iter_hasNext(&it)) {
+        char *src = ut_iter_next(&it);
+        if (!strcmp(src, "deps")) {
+            continue;
+        }
+
+        char *src_path = ut_asprintf("%s"UT_OS_PS"%s", project->path, src);
+        if (ut_file_test(src_path) != 1) {
+            ut_catch();
+            free(src_path);
+            continue;
+        }
+
+        ut_iter file_it;
+        if (ut_dir_iter(src_path, sources_pattern(config), &file_it)) {
+            free(src_path);
+            goto error;
+        }
+
+        while (ut_iter_hasNext(&file_it)) {
+            char *file = ut_iter_next(&file_it);
+            if (unity_excluded(driver, file)) {
+                continue;
+            }
+
+            /* Other languages (like Objective C) are compiled separately */
+            char *ext = strrchr(file, '.');
+            unity_batch *batch;
+            if (!strcmp(ext, ".c")) {
+                batch = c_files;
+            } else if (!strcmp(ext, ".cpp") || !strcmp(ext, ".cxx")) {
+                batch = cpp_files;
+            } else {
+                continue;
+            }
+
+            if (unity_is_ambiguous(project, src, file)) {
+                continue;
+            }
+
+            batch->files = realloc(
+                batch->files, (batch->count + 1) * sizeof(char*));
+            batch->files[batch->count ++] = ut_asprintf(
+                "%s/%s", src, file);
+
+            char *path = unity_source_path(project, src, file);
+            driver->set_attr_array("unity-sources", path);
+            free(path);
+        }
+
+        free(src_path);
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+/* Write unity source. Only write file when its contents change, so that the
+ * unity source is not recompiled when nothing changed. */
+static
+int16_t unity_write(
+    const char *file,
+    const char *content)
+{
+    if (ut_file_test(file) == 1) {
+        char *old = ut_file_load(file);
+        bool equal = old && !strcmp(old, content);
+        free(old);
+        if (equal) {
+            return 0;
+        }
+    }
+
+    FILE *f = fopen(file, "w");
+    if (!f) {
+        ut_throw("failed to open '%s'", file);
+        return -1;
+    }
+
+    fprintf(f, "%s", content);
+    fclose(f);
+
+    return 0;
+}
+
+/* Split sources in batches, and write a unity source for each batch that
+ * includes the sources in the batch. Sources are sorted so that batches don't
+ * change when the filesystem returns files in a different order. */
+static
+int16_t unity_write_batches(
+    unity_batch *batch,
+    uint32_t batch_size,
+    const char *unity_path,
+    const char *root,
+    ut_ll written)
+{
+    uint32_t i;
+
+    qsort(batch->files, batch->count, sizeof(char*), unity_compare);
+
+    for (i = 0; i < batch->count; i += batch_size) {
+        ut_strbuf content = UT_STRBUF_INIT;
+        uint32_t f;
+
+        ut_strbuf_appendstr(&content,
+            "/* Unity source generated by bake.lang.c. Do not edit! */\n\n");
+
+        for (f = i; f < batch->count && f < (i + batch_size); f ++) {
+            ut_strbuf_append(
+                &content, "#include \"%s%s\"\n", root, batch->files[f]);
+        }
+
+        char *name = ut_asprintf("unity_%s_%u.%s",
+            batch->ext, i / batch_size, batch->ext);
+        char *file = ut_asprintf("%s"UT_OS_PS"%s", unity_path, name);
+        char *content_str = ut_strbuf_get(&content);
+        int16_t ret = unity_write(file, content_str);
+
+        ut_ll_append(written, name);
+        free(content_str);
+        free(file);
+
+        if (ret) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Remove unity sources that are no longer used */
+static
+void unity_remove_stale(
+    const char *unity_path,
+    ut_ll written)
+{
+    ut_iter it;
+    if (ut_dir_iter(unity_path, NULL, &it)) {
+        ut_catch();
+        return;
+    }
+
+    while (ut_iter_hasNext(&it)) {
+        char *file = ut_iter_next(&it);
+        bool found = false;
+
+        ut_iter w_it = ut_ll_iter(written);
+        while (!found && ut_iter_hasNext(&w_it)) {
+            found = !strcmp(ut_iter_next(&w_it), file);
+        }
+
+        if (!found) {
+            char *file_path = ut_asprintf("%s"UT_OS_PS"%s", unity_path, file);
+            if (ut_rm(file_path)) {
+                ut_catch();
+            }
+            free(file_path);
+        }
+    }
+}
+
+/* Generate unity sources, which combine multiple project sources into a single
+ * translation unit so that headers are parsed once per batch. Unity sources are
+ * added to the project with the GENERATED-SOURCES pattern. */
+static
+void unity_generate(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project)
+{
+    uint32_t batch_size = unity_batch_size(driver, config, project);
+    char *unity_dir = driver->get_attr_string("unity-dir");
+    char *unity_path = ut_asprintf("%s"UT_OS_PS"%s", project->path, unity_dir);
+    unity_batch c_files = {.ext = "c"}, cpp_files = {.ext = "cpp"};
+    ut_ll written = ut_ll_new();
+    uint32_t i;
+
+    /* Unity sources include sources relative to the project root */
+    ut_strbuf root = UT_STRBUF_INIT;
+    char *ptr;
+    ut_strbuf_appendstr(&root, "../");
+    for (ptr = unity_dir; (ptr = strchr(ptr, UT_OS_PS[0])); ptr ++) {
+        ut_strbuf_appendstr(&root, "../");
+    }
+    char *root_str = ut_strbuf_get(&root);
+
+    if (ut_mkdir(unity_path)) {
+        goto error;
+    }
+
+    if (unity_collect(driver, config, project, &c_files, &cpp_files)) {
+        goto error;
+    }
+
+    if (unity_write_batches(
+        &c_files, batch_size, unity_path, root_str, written))
+    {
+        goto error;
+    }
+
+    if (unity_write_batches(
+        &cpp_files, batch_size, unity_path, root_str, written))
+    {
+        goto error;
+    }
+
+    unity_remove_stale(unity_path, written);
+
+    goto done;
+error:
+    ut_raise();
+    project->error = true;
+done:
+    for (i = 0; i < c_files.count; i ++) free(c_files.files[i]);
+    for (i = 0; i < cpp_files.count; i ++) free(cpp_files.files[i]);
+    free(c_files.files);
+    free(cpp_files.files);
+    ut_iter it = ut_ll_iter(written);
+    while (ut_iter_hasNext(&it)) free(ut_iter_next(&it));
+    ut_ll_free(written);
+    free(root_str);
+    free(unity_path);
+}
+
 /* Obtain object name from source file */
 static
 char* src_to_obj(
@@ -240,6 +665,21 @@ char* src_to_obj(
     const char *in)
 {
     char *obj_dir = driver->get_attr_string("obj-dir");
+
+    if (unity_enabled(driver, config, project)) {
+        /* Source is compiled as part of a unity source */
+        if (unity_contains(driver, project, in)) {
+            return NULL;
+        }
+
+        /* Don't add path of unity source to object name */
+        char *unity_dir = driver->get_attr_string("unity-dir");
+        size_t len = strlen(unity_dir);
+        if (!strncmp(in, unity_dir, len) && in[len] == UT_OS_PS[0]) {
+            in += len + 1;
+        }
+    }
+
     /* Add some dummy characters (__) to make room for the extension */
     char *result = ut_asprintf("%s"UT_OS_PS"%s__", obj_dir, in);
     char *ext = strrchr(result, '.');
@@ -283,6 +723,10 @@ void init(
         driver->set_attr_bool("export-symbols", false);
     }
 
+    if (!driver->get_attr("precompile-header")) {
+        driver->set_attr_bool("precompile-header", false);
+    }
+
     char *tmp_dir  = ut_asprintf(
         CACHE_DIR UT_OS_PS "%s-%s", config->build_target, 
         config->configuration);
@@ -292,6 +736,10 @@ void init(
     driver->set_attr_string("obj-dir", obj_dir);
     free(obj_dir);
 
+    char *unity_dir = ut_asprintf("%s"UT_OS_PS"unity", tmp_dir);
+    driver->set_attr_string("unity-dir", unity_dir);
+    free(unity_dir);
+
     if (!strcmp(driver->get_attr("c-standard")->is.string, "c89")) {
         driver->set_attr_array("cflags", "-D__BAKE_LEGACY__");
     }
@@ -427,6 +875,13 @@ void build(
     bake_config *config,
     bake_project *project)
 {
+    if (cif.build_pch && driver->get_attr_bool("precompile-header")) {
+        cif.build_pch(driver, config, project);
+    }
+
+    if (unity_enabled(driver, config, project)) {
+        unity_generate(driver, config, project);
+    }
 }
 
 static
@@ -614,11 +1069,7 @@ int bakemain(bake_driver_api *driver)
     /* Create pattern that matches source files */
     bake_config *cfg = driver->config();
 
-    if (!strcmp(cfg->build_os, "Darwin")) {
-        driver->pattern("SOURCES", "//*.c|*.cpp|*.cxx|*.m|*.mm");
-    } else {
-        driver->pattern("SOURCES", "//*.c|*.cpp|*.cxx");
-    }
+    driver->pattern("SOURCES", sources_pattern(cfg));
 
     /* Detect compiler & load compiler interface */
     if (is_msvc()) {
@@ -632,6 +1083,22 @@ int bakemain(bake_driver_api *driver)
     /* Create rule for dynamically generating object files from source files */
     driver->rule("objects", "$SOURCES", driver->target_map(src_to_obj), cif.compile);
 
+    /* Rebuild objects when the compiler command changes */
+    if (cif.compile_cmd) {
+        driver->command("objects", cif.compile_cmd);
+    }
+
+    /* Rebuild objects when headers change, if compiler generates dependency
+     * files for objects */
+    if (cif.dep_file) {
+        driver->dependency_rule(
+            "dependencies", "$objects", driver->target_map(cif.dep_file), NULL);
+    }
+
+    /* Add unity sources, which replace the sources they include */
+    driver->pattern("GENERATED-SOURCES", "${driver-attr unity-dir}/unity_*");
+    driver->condition("GENERATED-SOURCES", unity_enabled);
+
     /* Create rule for creating binary from objects */
     driver->rule("ARTEFACT", "$objects", driver->target_pattern(NULL), cif.link);
 
@@ -107,17 +107,17 @@ void msvc_add_flags(
     }
 }
 
-/* Compile source file for Windows platform using MSVC*/
+/* Obtain command that compiles source file for Windows platform using MSVC */
 static
-void msvc_compile_src(
+char* msvc_compile_cmd(
     bake_driver_api *driver,
     bake_config *config,
     bake_project *project,
-    char *source,
-    char *target)
+    const char *source,
+    const char *target)
 {
     ut_strbuf cmd = UT_STRBUF_INIT;
-    char *ext = strrchr(source, '.');
+    const char *ext = strrchr(source, '.');
     bool cpp = is_cpp(project);
 
     if (ext && strcmp(ext, ".c")) {
@@ -179,8 +179,19 @@ void msvc_compile_src(
         ut_strbuf_append(&cmd, " /Zi");
     }
 
-    /* Execute command */
-    char *cmdstr = ut_strbuf_get(&cmd);
+    return ut_strbuf_get(&cmd);
+}
+
+/* Compile source file */
+static
+void msvc_compile_src(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    char *source,
+    char *target)
+{
+    char *cmdstr = msvc_compile_cmd(driver, config, project, source, target);
     driver->exec(cmdstr);
     free(cmdstr);
 }
@@ -533,6 +544,7 @@ static
 bake_compiler_interface msvc_get() {
     bake_compiler_interface result = {
         .compile = msvc_compile_src,
+        .compile_cmd = msvc_compile_cmd,
         .link = msvc_link_binary,
         .clean_coverage = msvc_clean_coverage,
         .coverage = msvc_coverage,
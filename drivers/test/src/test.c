@@ -1,12 +1,36 @@
 
 #include <bake_test.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+
+#define BAKE_TEST_TIMING_FILE ".bake_cache"UT_OS_PS"test_timing.json"
+#define BAKE_TEST_HISTORY_FILE ".bake_cache"UT_OS_PS"test_history.json"
+
+/* Return codes of testcase process that are not a failure */
+#define BAKE_TEST_RC_EMPTY (2)
+#define BAKE_TEST_RC_FLAKY (3)
+#define BAKE_TEST_RC_QUARANTINED (4)
+
 static bake_test_suite *current_testsuite;
 static bake_test_case *current_testcase;
 
 static bool test_expect_abort_signal = false;
 static bool test_flaky = false;
 
+static bool test_fork_server = true;
+static int32_t test_slowest_count = 5;
+static uint32_t test_shard_index = 0;
+static uint32_t test_shard_count = 0;
+static const char *test_report_json = NULL;
+static const char *test_report_junit = NULL;
+static bool test_report_per_project = false;
+
 static const char *params[1024];
 static uint32_t param_count = 0;
 
@@ -28,7 +52,7 @@ void test_empty(void)
     ut_log("#[yellow]EMPTY#[reset] %s.%s (add test statements)\n", 
         current_testsuite->id, current_testcase->id);
 
-    exit(2);
+    exit(BAKE_TEST_RC_EMPTY);
 }
 
 static
@@ -192,17 +216,79 @@ bake_test_suite* bake_find_suite(
     return NULL;
 }
 
-typedef struct {
+/* Suite with one combination of parameter values */
+typedef struct bake_test_suite_run {
+    bake_test_suite *suite;
+    char *params;      /* Parameter arguments for test executable */
+    char *param_str;   /* Parameter values for report */
+    uint32_t remaining;
+    uint32_t fail;
+    uint32_t empty;
+    uint32_t pass;
+    bool skip;         /* All testcases are in another shard */
+} bake_test_suite_run;
+
+typedef enum bake_test_result {
+    BakeTestPass,
+    BakeTestFail,
+    BakeTestEmpty,
+    BakeTestFlaky,       /* Testcase marked as flaky failed */
+    BakeTestQuarantined
+} bake_test_result;
+
+static const char *bake_test_result_str[] = {
+    "pass", "fail", "empty", "flaky", "quarantined"
+};
+
+/* Testcase of a run */
+typedef struct bake_test_job {
+    uint32_t run;
+    uint32_t testcase;
+    uint32_t index;
+    double expected_time;
+    bake_test_result result;
+    int8_t rc;
+    int sig;
+    int32_t retries;
+    double wall_time;
+    double cpu_time;
+} bake_test_job;
+
+/* Duration of testcase in previous runs */
+typedef struct bake_test_history {
+    char *testcase;
+    double duration;
+} bake_test_history;
+
+/* Testcases of all runs are added to a single queue, so that workers stay busy
+ * until the last testcase has been picked up, even when suites are small or
+ * some testcases are slow. Results are reported per run, in the order in which
+ * runs were added. */
+typedef struct bake_test_exec_ctx {
     const char *test_project;
     const char *exec;
-    bake_test_suite *suite;
+    bake_test_suite_run *runs;
+    uint32_t run_count;
+    bake_test_job *jobs;
+    uint32_t job_count;
+    uint32_t next_job;
+    uint32_t next_report;
+    bool all_suites;
+    bool fork_server;
+    uint32_t suite_fail;
+    uint32_t suite_empty;
     uint32_t fail;
     uint32_t empty;
     uint32_t pass;
-    uint32_t offset;
-    uint32_t count;
     int8_t result;
-    ut_thread job;
+    FILE *report_json;
+    FILE *report_junit;
+    char *report_junit_file;
+    uint32_t junit_tests;
+    uint32_t junit_failures;
+    uint32_t junit_errors;
+    uint32_t junit_skipped;
+    struct ut_mutex_s lock;
 } bake_test_exec_ctx;
 
 static
@@ -225,45 +311,409 @@ void bake_test_cmd_append_params(
 }
 
 static
-void* bake_test_run_suite_range(
-    bake_test_exec_ctx *ctx)
+char* bake_test_param_str(
+    bake_test_suite *suite)
 {
-    int8_t result = 0;
-    uint32_t fail = 0, empty = 0, pass = 0;
-    uint32_t offset = ctx->offset, count = ctx->count;
-    const char *exec = ctx->exec;
-    bake_test_suite *suite = ctx->suite;
-    const char *prefix = ut_getenv("BAKE_TEST_PREFIX");
+    if (!suite->param_count) {
+        return ut_strdup("");
+    }
+
+    ut_strbuf buf = UT_STRBUF_INIT;
+    ut_strbuf_append(&buf, " [ ");
+
+    uint32_t p;
+    for (p = 0; p < suite->param_count; p ++) {
+        if (p) {
+            ut_strbuf_append(&buf, "#[reset], ");
+        }
+        bake_test_param *param = &suite->params[p];
+        char *value = param->values[param->value_cur];
+        ut_strbuf_append(&buf, "#[grey]%s#[reset]: #[green]%s", param->name, value);
+    }
+    ut_strbuf_append(&buf, " #[reset]]");
+
+    return ut_strbuf_get(&buf);
+}
+
+/* Add run for suite with the current parameter values */
+static
+void bake_test_add_run(
+    bake_test_exec_ctx *ctx,
+    bake_test_suite *suite)
+{
+    ctx->runs = realloc(ctx->runs, 
+        (ctx->run_count + 1) * sizeof(bake_test_suite_run));
+    bake_test_suite_run *run = &ctx->runs[ctx->run_count];
+    memset(run, 0, sizeof(bake_test_suite_run));
+
+    ut_strbuf params = UT_STRBUF_INIT;
+    bake_test_cmd_append_params(&params, suite);
+    run->params = ut_strbuf_get(&params);
+    if (!run->params) {
+        run->params = ut_strdup("");
+    }
+
+    run->suite = suite;
+    run->param_str = bake_test_param_str(suite);
+    run->remaining = suite->testcase_count;
+
+    ctx->jobs = realloc(ctx->jobs, 
+        (ctx->job_count + suite->testcase_count) * sizeof(bake_test_job));
 
     uint32_t t;
-    for (t = offset; t < (offset + count); t ++) {
-        bake_test_case *test = &suite->testcases[t];
+    for (t = 0; t < suite->testcase_count; t ++) {
+        ctx->jobs[ctx->job_count ++] = (bake_test_job){
+            .run = ctx->run_count,
+            .testcase = t
+        };
+    }
+
+    ctx->run_count ++;
+}
+
+/* Add run for each combination of parameter values */
+static
+void bake_test_add_param_runs(
+    bake_test_exec_ctx *ctx,
+    bake_test_suite *suite,
+    uint32_t param)
+{
+    if (param == suite->param_count) {
+        bake_test_add_run(ctx, suite);
+        return;
+    }
+
+    bake_test_param *p = &suite->params[param];
+    int32_t v;
+    for (v = 0; v < p->value_count; v ++) {
+        p->value_cur = v;
+        bake_test_add_param_runs(ctx, suite, param + 1);
+    }
+}
+
+#ifndef _WIN32
+
+/* A fork server is a test executable that is started once per worker. It reads
+ * testcases from the request pipe, and forks a process for each testcase, so
+ * that the executable doesn't have to be loaded and initialized for every
+ * testcase while testcases still run in isolation. After the testcase finished,
+ * the server writes the signal and return code of the process to the response
+ * pipe. */
+typedef struct bake_test_server {
+    pid_t pid;
+    int request;
+    FILE *response;
+} bake_test_server;
+
+static
+int16_t bake_test_pipe(
+    int fds[2])
+{
+    if (pipe(fds)) {
+        return -1;
+    }
+
+    /* Prevent pipes from leaking into processes started by other workers */
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    return 0;
+}
+
+static
+int16_t bake_test_server_start(
+    bake_test_server *server,
+    const char *exec)
+{
+    int request[2], response[2];
+
+    if (bake_test_pipe(request)) {
+        return -1;
+    }
+
+    if (bake_test_pipe(response)) {
+        close(request[0]);
+        close(request[1]);
+        return -1;
+    }
+
+    /* Format arguments before forking, as the child of a multithreaded process
+     * should only call async-signal-safe functions */
+    char request_str[16], response_str[16];
+    sprintf(request_str, "%d", request[0]);
+    sprintf(response_str, "%d", response[1]);
+
+    pid_t pid = fork();
+    if (!pid) {
+        /* Requests are not passed on stdin, so testcases can still use it */
+        fcntl(request[0], F_SETFD, 0);
+        fcntl(response[1], F_SETFD, 0);
+        execlp(exec, exec, "--fork-server", request_str, response_str, NULL);
+        _exit(127);
+    }
+
+    close(request[0]);
+    close(response[1]);
+
+    if (pid == -1) {
+        close(request[1]);
+        close(response[0]);
+        return -1;
+    }
+
+    server->pid = pid;
+    server->request = request[1];
+    server->response = fdopen(response[0], "r");
+
+    return 0;
+}
+
+static
+void bake_test_server_stop(
+    bake_test_server *server)
+{
+    if (server->pid) {
+        /* Empty line stops the server */
+        if (write(server->request, "\n", 1) != 1) {
+            kill(server->pid, SIGKILL);
+        }
+        close(server->request);
+        fclose(server->response);
+        while (waitpid(server->pid, NULL, 0) == -1 && errno == EINTR) { }
+        server->pid = 0;
+    }
+}
+
+static
+double bake_test_cpu_time(
+    struct rusage *ru)
+{
+    return (double)(ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) +
+        (double)(ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) / 1000000.0;
+}
+
+/* Wait for testcase process, and obtain the CPU time it used */
+static
+int bake_test_wait(
+    pid_t pid,
+    int8_t *rc_out,
+    double *cpu_out)
+{
+    struct rusage ru;
+    int status = 0;
+
+    while (wait4(pid, &status, 0, &ru) == -1) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+
+    *cpu_out = bake_test_cpu_time(&ru);
+
+    if (WIFSIGNALED(status)) {
+        return WTERMSIG(status);
+    }
+
+    *rc_out = WEXITSTATUS(status);
+
+    return 0;
+}
+
+/* Run testcase in fork server. Returns the signal with which the testcase
+ * process exited, or -1 if the server is not responding. */
+static
+int bake_test_server_run(
+    bake_test_server *server,
+    const char *test_name,
+    const char *params,
+    int8_t *rc_out,
+    double *cpu_out)
+{
+    char *request = ut_asprintf("%s%s\n", test_name, params);
+    size_t len = strlen(request);
+    ssize_t written = write(server->request, request, len);
+    free(request);
+
+    if (written != (ssize_t)len) {
+        return -1;
+    }
+
+    char response[64];
+    int sig, rc;
+    if (!fgets(response, sizeof(response), server->response) ||
+        sscanf(response, "%d %d %lf", &sig, &rc, cpu_out) != 3)
+    {
+        return -1;
+    }
+
+    *rc_out = rc;
+
+    return sig;
+}
+
+/* Main loop of fork server, runs in test executable */
+static
+int bake_test_fork_server(
+    bake_test_suite *suites,
+    uint32_t suite_count,
+    int request_fd,
+    int response_fd)
+{
+    FILE *request = fdopen(request_fd, "r");
+    FILE *response = fdopen(response_fd, "w");
+    char line[4096];
+
+    if (!request || !response) {
+        ut_error("invalid file descriptor for fork server");
+        if (request) fclose(request);
+        if (response) fclose(response);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), request)) {
+        char *nl = strchr(line, '\n');
+        if (nl) {
+            *nl = '\0';
+        }
+
+        if (!line[0]) {
+            break;
+        }
+
+        /* Don't let testcase inherit unflushed output */
+        fflush(stdout);
+        fflush(stderr);
+
+        pid_t pid = fork();
+        if (!pid) {
+            fclose(request);
+            fclose(response);
+
+            char *test_name = strtok(line, " ");
+            char *arg;
+            while ((arg = strtok(NULL, " "))) {
+                if (!strcmp(arg, "--param")) {
+                    char *param = strtok(NULL, " ");
+                    if (param) {
+                        bake_add_param(param);
+                    }
+                }
+            }
+
+            int result = bake_test_run_single_test(
+                suites, suite_count, test_name);
+            ut_deinit();
+            exit(result);
+        }
 
-        char *test_name = ut_asprintf("%s.%s", suite->id, test->id);
-        ut_proc proc;
-        int8_t rc = 0;
         int sig = 0;
-        bool proc_fail = false;
-        int32_t retry_count = 0;
+        int8_t rc = 0;
+        double cpu_time = 0;
+
+        if (pid == -1) {
+            rc = -1;
+            ut_error("fork failed: %s", strerror(errno));
+        } else if ((sig = bake_test_wait(pid, &rc, &cpu_time)) == -1) {
+            sig = 0;
+            rc = -1;
+            ut_error("wait failed: %s", strerror(errno));
+        }
+
+        fprintf(response, "%d %d %f\n", sig, rc, cpu_time);
+        fflush(response);
+    }
+
+    fclose(request);
+    fclose(response);
+
+    return 0;
+}
+
+#else
 
-retry:
-        memset(&proc, 0, sizeof(ut_proc));
+typedef struct bake_test_server {
+    int pid;
+} bake_test_server;
 
+static
+int16_t bake_test_server_start(
+    bake_test_server *server,
+    const char *exec)
+{
+    return -1;
+}
+
+static
+void bake_test_server_stop(
+    bake_test_server *server) { }
+
+static
+int bake_test_server_run(
+    bake_test_server *server,
+    const char *test_name,
+    const char *params,
+    int8_t *rc_out,
+    double *cpu_out)
+{
+    return -1;
+}
+
+#endif
+
+static
+bake_test_result bake_test_run_testcase(
+    bake_test_exec_ctx *ctx,
+    bake_test_server *server,
+    bake_test_suite_run *run,
+    bake_test_case *test,
+    bake_test_job *job)
+{
+    bake_test_result result = BakeTestPass;
+    bake_test_suite *suite = run->suite;
+    const char *prefix = ut_getenv("BAKE_TEST_PREFIX");
+
+    char *test_name = ut_asprintf("%s.%s", suite->id, test->id);
+    int8_t rc = 0;
+    int sig = 0;
+    int32_t retry_count = 0;
+
+retry: {
         ut_strbuf cmd = UT_STRBUF_INIT;
         if (prefix) {
-            ut_strbuf_append(&cmd, "%s ");
+            ut_strbuf_append(&cmd, "%s ", prefix);
         }
 
-        ut_strbuf_append(&cmd, "%s %s", exec, test_name);
+        ut_strbuf_append(&cmd, "%s %s%s", ctx->exec, test_name, run->params);
+
+        char *cmd_str = ut_strbuf_get(&cmd);
 
-        if (suite->param_count) {
-            bake_test_cmd_append_params(&cmd, suite);
+        sig = -1;
+        if (server->pid) {
+            sig = bake_test_server_run(
+                server, test_name, run->params, &rc, &job->cpu_time);
+            if (sig == -1) {
+                ut_log("#[grey]fork server stopped responding\n");
+                bake_test_server_stop(server);
+            }
         }
 
-        char *cmd_str = ut_strbuf_get(&cmd);
-        sig = ut_proc_cmd(cmd_str, &rc);
+        if (sig == -1) {
+#ifndef _WIN32
+            ut_proc pid = ut_proc_cmd_run(cmd_str);
+            if (pid) {
+                sig = bake_test_wait(pid, &rc, &job->cpu_time);
+            }
+#else
+            sig = ut_proc_cmd(cmd_str, &rc);
+#endif
+        }
 
-        if (sig || rc) {
+        if (!sig && rc == BAKE_TEST_RC_FLAKY) {
+            /* Failure of flaky testcase has already been reported */
+            result = BakeTestFlaky;
+        } else if (!sig && rc == BAKE_TEST_RC_QUARANTINED) {
+            result = BakeTestQuarantined;
+        } else if (sig || rc) {
             ut_catch();
             if (sig) {
                 if (sig == 6) {
@@ -281,6 +731,7 @@ retry:
                              * limited. */
                             ut_sleep(0, 100 * 1000 * 1000);
                             ut_log("#[grey]retrying after sig 4...\n");
+                            free(cmd_str);
                             goto retry;
                         } else {
                             ut_log("#[red]retried 5 times after sig 4\n");
@@ -289,13 +740,12 @@ retry:
                     ut_log("#[red]FAIL#[reset]: %s exited with signal %d\n", 
                         test_name, sig);
                 }
-                result = -1;
-                fail ++;
+                result = BakeTestFail;
             } else {
-                if (rc == 2) {
+                if (rc == BAKE_TEST_RC_EMPTY) {
                     /* Testcase is empty. No action required, but print the
                      * test command on command line */
-                    empty ++;
+                    result = BakeTestEmpty;
                 } else if (rc != -1) {
                     /* If return code is not -1, this was not a simple
                      * testcase failure (which already has been reported) */
@@ -303,244 +753,863 @@ retry:
                         "#[red]FAIL#[reset]: %s failed with return code %d\n", 
                         test_name, rc);
 
-                    result = -1;
-                    fail ++;
+                    result = BakeTestFail;
                 } else {
                     /* Normal test failure */
-                    result = -1;
-                    fail ++;
+                    result = BakeTestFail;
                 }
             }
 
             ut_catch();
             print_dbg_command(ctx->test_project, cmd_str);
-        } else if (proc_fail) {
-            ut_log("Testcase '%s' failed to start\n", test_name);
         } else {
             if (ut_log_verbosityGet() <= UT_OK) {
                 ut_log("#[green]PASS#[reset] %s.%s\n", 
                     suite->id, test->id);
             }
-            pass ++;
         }
 
         free(cmd_str);
-        free(test_name);
     }
 
-    ctx->fail = fail;
-    ctx->empty = empty;
-    ctx->pass = pass;
-    
-    ctx->result = result;
+    free(test_name);
 
-    return 0;
+    job->rc = rc;
+    job->sig = sig;
+    job->retries = retry_count;
+
+    return result;
 }
 
+/* Report runs that have finished, in the order in which they were added. Must
+ * be called with the lock held. */
 static
-int8_t bake_test_run_suite(
-    const char *test_id,
-    const char *exec,
-    bake_test_suite *suite,
-    uint32_t *fail_out,
-    uint32_t *empty_out,
-    uint32_t *pass_out,
-    uint32_t job_count)
+void bake_test_report_runs(
+    bake_test_exec_ctx *ctx)
 {
-    assert(test_id != NULL);
-    assert(exec != NULL);
-    assert(strlen(exec) != 0);
+    while (ctx->next_report < ctx->run_count) {
+        bake_test_suite_run *run = &ctx->runs[ctx->next_report];
+        if (run->remaining) {
+            break;
+        }
 
-    uint32_t i, cur = 0;
-    float next = 0, tests_per_runner = 
-        (float)suite->testcase_count / (float)job_count;
-
-    bake_test_exec_ctx *ctx = ut_calloc(
-        sizeof(bake_test_exec_ctx) * job_count);
-    assert(ctx != NULL);
-
-    // Divide the work
-    for (i = 0; i < job_count; i ++) {
-        next += tests_per_runner;
-        ctx[i].test_project = test_id;
-        ctx[i].exec = exec;
-        ctx[i].suite = suite;
-        ctx[i].offset = cur;
-        ctx[i].count = next - cur;
-        
-        if (i == (job_count - 1)) {
-            ctx[i].count += suite->testcase_count - ((uint32_t)next);
-            assert(cur + ctx[i].count == suite->testcase_count);
+        if (run->skip) {
+            ctx->next_report ++;
+            continue;
         }
 
-        cur += ctx[i].count;
-    }
+        bake_test_report(ctx->test_project, run->suite->id, run->param_str, 
+            run->fail, run->empty, run->pass);
 
-    // Run jobs
-    for (i = 0; i < job_count; i ++) {
-        ctx[i].job = ut_thread_new(
-            (ut_thread_cb)bake_test_run_suite_range, &ctx[i]);
+        ctx->suite_fail += run->fail;
+        ctx->suite_empty += run->empty;
+        ctx->next_report ++;
+
+        /* Separate suites with failed or empty testcases from the next */
+        if (ctx->next_report == ctx->run_count || 
+            ctx->runs[ctx->next_report].suite != run->suite)
+        {
+            if (ctx->all_suites && (ctx->suite_fail || ctx->suite_empty)) {
+                ut_log("\n");
+            }
+            ctx->suite_fail = 0;
+            ctx->suite_empty = 0;
+        }
     }
+}
 
-    // Wait for jobs to complete
-    for (i = 0; i < job_count; i ++) {
-        ut_thread_join(ctx[i].job, NULL);
+static
+void bake_test_json_str(
+    FILE *f,
+    const char *str)
+{
+    const char *ptr;
+    char ch;
+
+    fputc('"', f);
+    for (ptr = str; (ch = *ptr); ptr ++) {
+        if (ch == '"' || ch == '\\') {
+            fputc('\\', f);
+        }
+        fputc(ch, f);
     }
+    fputc('"', f);
+}
 
-    // Collect results
-    for (i = 1; i < job_count; i ++) {
-        ctx->pass += ctx[i].pass;
-        ctx->fail += ctx[i].fail;
-        ctx->empty += ctx[i].empty;
-        ctx->result |= ctx[i].result;
+/* Write parameters of run as JSON object member. Parameters are stored as
+ * "--param name=value" arguments. */
+static
+void bake_test_json_params(
+    FILE *f,
+    const char *params)
+{
+    if (!params[0]) {
+        return;
     }
 
-    // Report
-    if (!suite->param_count) {
-        bake_test_report(
-            test_id, suite->id, "", ctx->fail, ctx->empty, ctx->pass);
-    } else {
-        ut_strbuf buf = UT_STRBUF_INIT;
-        ut_strbuf_append(&buf, " [ ");
+    char *buf = ut_strdup(params);
+    char *arg, *save = NULL;
+    bool first = true;
+
+    fprintf(f, ", \"params\": {");
+    for (arg = strtok_r(buf, " ", &save); arg; 
+        arg = strtok_r(NULL, " ", &save)) 
+    {
+        char *value = strchr(arg, '=');
+        if (strcmp(arg, "--param") && value) {
+            *value = '\0';
+            fprintf(f, "%s", first ? "" : ", ");
+            bake_test_json_str(f, arg);
+            fprintf(f, ": ");
+            bake_test_json_str(f, value + 1);
+            first = false;
+        }
+    }
+    fprintf(f, "}");
+    free(buf);
+}
 
-        uint32_t p;
-        for (p = 0; p < suite->param_count; p ++) {
-            if (p) {
-                ut_strbuf_append(&buf, "#[reset], ");
-            }
-            bake_test_param *param = &suite->params[p];
-            char *value = param->values[param->value_cur];
-            ut_strbuf_append(&buf, "#[grey]%s#[reset]: #[green]%s", param->name, value);
+static
+void bake_test_xml_str(
+    FILE *f,
+    const char *str)
+{
+    const char *ptr;
+    char ch;
+
+    for (ptr = str; (ch = *ptr); ptr ++) {
+        if (ch == '&') {
+            fputs("&amp;", f);
+        } else if (ch == '<') {
+            fputs("&lt;", f);
+        } else if (ch == '>') {
+            fputs("&gt;", f);
+        } else if (ch == '"') {
+            fputs("&quot;", f);
+        } else {
+            fputc(ch, f);
         }
-        ut_strbuf_append(&buf, " #[reset]]");
+    }
+}
 
-        char *param_str = ut_strbuf_get(&buf);
-        bake_test_report(
-            test_id, suite->id, param_str, ctx->fail, ctx->empty, ctx->pass);
-        free(param_str);
+/* When tests of multiple projects are reported to the same location, insert
+ * the project id before the file extension so projects don't overwrite each
+ * other's reports (results.xml becomes results.<project>.xml). */
+static
+char* bake_test_report_file(
+    const char *file,
+    const char *project)
+{
+    if (!test_report_per_project) {
+        return ut_strdup(file);
     }
 
-    int8_t result = ctx->result;
-    if (fail_out) {
-        *fail_out = ctx->fail;
+    const char *base = strrchr(file, '/');
+    const char *ext = strrchr(base ? base : file, '.');
+    if (!ext || ext == (base ? base + 1 : file)) {
+        return ut_asprintf("%s.%s", file, project);
     }
-    if (empty_out) {
-        *empty_out = ctx->empty;
+
+    return ut_asprintf("%.*s.%s%s", (int)(ext - file), file, project, ext);
+}
+
+static
+FILE* bake_test_report_open(
+    const char *file)
+{
+    char *dir = ut_path_dirname(file);
+    if (dir && dir[0] && ut_mkdir(dir)) {
+        ut_catch();
     }
-    if (pass_out) {
-        *pass_out = ctx->pass;
+    free(dir);
+
+    FILE *f = fopen(file, "w");
+    if (!f) {
+        ut_warning("failed to open report '%s': %s", file, strerror(errno));
     }
 
-    free(ctx);
+    return f;
+}
 
-    return result;
+/* Open structured reports. JSON results are written as testcases complete, so
+ * that they can be consumed while tests are still running. JUnit testcases are
+ * collected in a temporary file, as the testsuite element that precedes them
+ * contains the totals. */
+static
+void bake_test_report_start(
+    bake_test_exec_ctx *ctx)
+{
+    if (test_report_json) {
+        char *file = bake_test_report_file(test_report_json, ctx->test_project);
+        ctx->report_json = bake_test_report_open(file);
+        free(file);
+    }
+
+    if (test_report_junit) {
+        ctx->report_junit_file = bake_test_report_file(
+            test_report_junit, ctx->test_project);
+        ctx->report_junit = tmpfile();
+        if (!ctx->report_junit) {
+            ut_warning("failed to create temporary file for report '%s': %s",
+                ctx->report_junit_file, strerror(errno));
+        }
+    }
 }
 
 static
-int8_t bake_test_run_suite_for_param(
-    const char *test_id,
-    const char *exec,
-    bake_test_suite *suite,
-    uint32_t *fail,
-    uint32_t *empty, 
-    uint32_t *pass,
-    uint32_t job_count,
-    uint32_t param)
+void bake_test_report_json(
+    bake_test_exec_ctx *ctx,
+    bake_test_job *job)
 {
-    bake_test_param *p = &suite->params[param];
-    int32_t v;
-    int8_t result = 0;
+    FILE *f = ctx->report_json;
+    bake_test_suite_run *run = &ctx->runs[job->run];
+    bake_test_case *test = &run->suite->testcases[job->testcase];
+
+    fprintf(f, "{\"project\": ");
+    bake_test_json_str(f, ctx->test_project);
+    fprintf(f, ", \"suite\": ");
+    bake_test_json_str(f, run->suite->id);
+    fprintf(f, ", \"testcase\": ");
+    bake_test_json_str(f, test->id);
+    bake_test_json_params(f, run->params);
+    fprintf(f, ", \"result\": \"%s\", \"rc\": %d, \"signal\": %d, "
+        "\"retries\": %d, \"wall_time\": %.6f, \"cpu_time\": %.6f}\n",
+        bake_test_result_str[job->result], job->rc, job->sig, job->retries,
+        job->wall_time, job->cpu_time);
+    fflush(f);
+}
 
-    for (v = 0; v < p->value_count; v ++) {
-        p->value_cur = v;
-        if (param < (suite->param_count - 1)) {
-            if (bake_test_run_suite_for_param(
-                test_id, exec, suite, fail, empty, pass, job_count, param + 1)) 
-            {
-                result = -1;
+static
+void bake_test_report_junit(
+    bake_test_exec_ctx *ctx,
+    bake_test_job *job)
+{
+    FILE *f = ctx->report_junit;
+    bake_test_suite_run *run = &ctx->runs[job->run];
+    bake_test_case *test = &run->suite->testcases[job->testcase];
+
+    fprintf(f, "    <testcase classname=\"");
+    bake_test_xml_str(f, run->suite->id);
+    fprintf(f, "\" name=\"");
+    bake_test_xml_str(f, test->id);
+
+    /* Testcases of parameterized suites are identified by their parameters */
+    if (run->params[0]) {
+        char *params = ut_strdup(run->params);
+        char *arg, *save = NULL;
+        bool first = true;
+
+        fprintf(f, "[");
+        for (arg = strtok_r(params, " ", &save); arg; 
+            arg = strtok_r(NULL, " ", &save)) 
+        {
+            if (strcmp(arg, "--param")) {
+                fprintf(f, "%s", first ? "" : ",");
+                bake_test_xml_str(f, arg);
+                first = false;
             }
+        }
+        fprintf(f, "]");
+        free(params);
+    }
+
+    fprintf(f, "\" time=\"%.6f\">\n", job->wall_time);
+
+    /* A testcase that crashed is an error, a failed assert is a failure */
+    if (job->result == BakeTestFail) {
+        if (job->sig) {
+            fprintf(f, "      <error message=\"exited with signal %d\"/>\n",
+                job->sig);
+            ctx->junit_errors ++;
         } else {
-            if (!suite->param_count) {
-                uint32_t test_fail = 0;
-                uint32_t test_empty = 0; 
-                uint32_t test_pass = 0;
-                if (bake_test_run_suite(test_id, exec, suite, 
-                    &test_fail, &test_empty, &test_pass, job_count)) 
-                {
-                    result = -1;
-                }
-                *fail += test_fail;
-                *empty += test_empty;
-                *pass += test_pass;
-            } else {
-                uint32_t test_fail = 0;
-                uint32_t test_empty = 0; 
-                uint32_t test_pass = 0;
-                if (bake_test_run_suite(test_id, exec, suite, 
-                    &test_fail, &test_empty, &test_pass, job_count)) 
-                {
-                    result = -1;
-                }
-                *fail += test_fail;
-                *empty += test_empty;
-                *pass += test_pass;
+            fprintf(f, "      <failure message=\"failed with return code %d\"/>\n",
+                job->rc);
+            ctx->junit_failures ++;
+        }
+    } else if (job->result == BakeTestEmpty) {
+        fprintf(f, "      <skipped message=\"empty testcase\"/>\n");
+        ctx->junit_skipped ++;
+    } else if (job->result == BakeTestQuarantined) {
+        fprintf(f, "      <skipped message=\"quarantined\"/>\n");
+        ctx->junit_skipped ++;
+    }
+
+    ctx->junit_tests ++;
+
+    fprintf(f, "      <properties>\n");
+    fprintf(f, "        <property name=\"result\" value=\"%s\"/>\n",
+        bake_test_result_str[job->result]);
+    fprintf(f, "        <property name=\"rc\" value=\"%d\"/>\n", job->rc);
+    fprintf(f, "        <property name=\"signal\" value=\"%d\"/>\n", job->sig);
+    fprintf(f, "        <property name=\"retries\" value=\"%d\"/>\n",
+        job->retries);
+    fprintf(f, "        <property name=\"cpu_time\" value=\"%.6f\"/>\n",
+        job->cpu_time);
+    fprintf(f, "      </properties>\n");
+    fprintf(f, "    </testcase>\n");
+}
+
+/* Write result of testcase to structured reports. Must be called with the lock
+ * held. */
+static
+void bake_test_report_testcase(
+    bake_test_exec_ctx *ctx,
+    bake_test_job *job)
+{
+    if (ctx->report_json) {
+        bake_test_report_json(ctx, job);
+    }
+
+    if (ctx->report_junit) {
+        bake_test_report_junit(ctx, job);
+    }
+}
+
+static
+void bake_test_report_stop(
+    bake_test_exec_ctx *ctx)
+{
+    if (ctx->report_json) {
+        fclose(ctx->report_json);
+        ctx->report_json = NULL;
+    }
+
+    if (ctx->report_junit) {
+        FILE *f = bake_test_report_open(ctx->report_junit_file);
+        if (f) {
+            char buf[4096];
+            size_t n;
+
+            fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+            fprintf(f, "<testsuites name=\"");
+            bake_test_xml_str(f, ctx->test_project);
+            fprintf(f, "\" tests=\"%u\" failures=\"%u\" errors=\"%u\">\n",
+                ctx->junit_tests, ctx->junit_failures, ctx->junit_errors);
+            fprintf(f, "  <testsuite name=\"");
+            bake_test_xml_str(f, ctx->test_project);
+            fprintf(f, "\" tests=\"%u\" failures=\"%u\" errors=\"%u\" "
+                "skipped=\"%u\">\n", ctx->junit_tests, ctx->junit_failures,
+                ctx->junit_errors, ctx->junit_skipped);
+
+            rewind(ctx->report_junit);
+            while ((n = fread(buf, 1, sizeof(buf), ctx->report_junit))) {
+                fwrite(buf, 1, n, f);
             }
+
+            fprintf(f, "  </testsuite>\n</testsuites>\n");
+            fclose(f);
         }
+
+        fclose(ctx->report_junit);
+        ctx->report_junit = NULL;
     }
 
-    return result;
+    free(ctx->report_junit_file);
+    ctx->report_junit_file = NULL;
 }
 
 static
-int8_t bake_test_run_all_tests(
-    const char *test_id,
-    const char *exec,
-    bake_test_suite *suites,
-    uint32_t suite_count,
-    uint32_t job_count)
+void* bake_test_worker(
+    bake_test_exec_ctx *ctx)
+{
+    bake_test_server server = {0};
+
+    if (ctx->fork_server) {
+        if (bake_test_server_start(&server, ctx->exec)) {
+            server.pid = 0;
+        }
+    }
+
+    ut_mutex_lock(&ctx->lock);
+
+    while (ctx->next_job < ctx->job_count) {
+        bake_test_job *job = &ctx->jobs[ctx->next_job ++];
+        bake_test_suite_run *run = &ctx->runs[job->run];
+        bake_test_case *test = &run->suite->testcases[job->testcase];
+
+        ut_mutex_unlock(&ctx->lock);
+
+        struct timespec start;
+        timespec_gettime(&start);
+
+        bake_test_result result = bake_test_run_testcase(
+            ctx, &server, run, test, job);
+
+        job->wall_time = timespec_measure(&start);
+        job->result = result;
+
+        ut_mutex_lock(&ctx->lock);
+
+        if (result == BakeTestEmpty) {
+            run->empty ++;
+            ctx->empty ++;
+        } else if (result == BakeTestFail) {
+            run->fail ++;
+            ctx->fail ++;
+            ctx->result = -1;
+        } else {
+            /* Flaky and quarantined testcases don't fail the suite */
+            run->pass ++;
+            ctx->pass ++;
+        }
+
+        run->remaining --;
+        bake_test_report_testcase(ctx, job);
+        bake_test_report_runs(ctx);
+    }
+
+    ut_mutex_unlock(&ctx->lock);
+
+    bake_test_server_stop(&server);
+
+    return NULL;
+}
+
+static
+int bake_test_compare_wall_time(
+    const void *ptr1,
+    const void *ptr2)
 {
-    int8_t result = 0;
+    const bake_test_job *job1 = *(bake_test_job**)ptr1;
+    const bake_test_job *job2 = *(bake_test_job**)ptr2;
+
+    if (job1->wall_time < job2->wall_time) {
+        return 1;
+    } else if (job1->wall_time > job2->wall_time) {
+        return -1;
+    }
 
-    uint32_t total_fail = 0, total_empty = 0, total_pass = 0;
-    uint32_t fail = 0, empty = 0, pass = 0;
+    return 0;
+}
 
+static
+void bake_test_report_slowest(
+    bake_test_exec_ctx *ctx)
+{
+    uint32_t i, count = test_slowest_count;
+    if (!count || !ctx->job_count) {
+        return;
+    }
+
+    bake_test_job **jobs = malloc(ctx->job_count * sizeof(bake_test_job*));
+    for (i = 0; i < ctx->job_count; i ++) {
+        jobs[i] = &ctx->jobs[i];
+    }
+
+    qsort(jobs, ctx->job_count, sizeof(bake_test_job*), 
+        bake_test_compare_wall_time);
+
+    if (count > ctx->job_count) {
+        count = ctx->job_count;
+    }
+
+    ut_log("slowest testcases:\n");
+    for (i = 0; i < count; i ++) {
+        bake_test_suite_run *run = &ctx->runs[jobs[i]->run];
+        bake_test_case *test = &run->suite->testcases[jobs[i]->testcase];
+        ut_log("  %8.3fs #[grey](cpu %.3fs)#[reset] %s.%s%s#[reset]\n", 
+            jobs[i]->wall_time, jobs[i]->cpu_time, run->suite->id, test->id,
+            run->param_str);
+    }
     ut_log("\n");
 
+    free(jobs);
+}
+
+/* Write timing of all testcases to the project cache */
+static
+void bake_test_write_timing(
+    bake_test_exec_ctx *ctx)
+{
+    if (ut_mkdir(".bake_cache")) {
+        ut_catch();
+        return;
+    }
+
+    FILE *f = fopen(BAKE_TEST_TIMING_FILE, "w");
+    if (!f) {
+        ut_warning("failed to write '%s': %s", 
+            BAKE_TEST_TIMING_FILE, strerror(errno));
+        return;
+    }
+
+    fprintf(f, "{\n  \"project\": ");
+    bake_test_json_str(f, ctx->test_project);
+    fprintf(f, ",\n  \"testcases\": [");
+
     uint32_t i;
-    for (i = 0; i < suite_count; i ++) {
-        bake_test_suite *suite = &suites[i];
+    for (i = 0; i < ctx->job_count; i ++) {
+        bake_test_job *job = &ctx->jobs[i];
+        bake_test_suite_run *run = &ctx->runs[job->run];
+        bake_test_case *test = &run->suite->testcases[job->testcase];
 
-        fail = 0;
-        empty = 0;
-        pass = 0;
+        fprintf(f, "%s\n    {\"suite\": ", i ? "," : "");
+        bake_test_json_str(f, run->suite->id);
+        fprintf(f, ", \"testcase\": ");
+        bake_test_json_str(f, test->id);
 
-        if (!suite->param_count) {
-            if (bake_test_run_suite(
-                test_id, exec, suite, &fail, &empty, &pass, job_count)) 
-            {
-                result = -1;
-            }
+        bake_test_json_params(f, run->params);
+
+        fprintf(f, ", \"result\": \"%s\", \"wall_time\": %.6f, "
+            "\"cpu_time\": %.6f}", 
+            bake_test_result_str[job->result], job->wall_time, job->cpu_time);
+    }
+
+    fprintf(f, "\n  ]\n}\n");
+    fclose(f);
+}
+
+static
+int bake_test_history_compare(
+    void *ctx,
+    const void* key1,
+    const void* key2)
+{
+    return strcmp(key1, key2);
+}
+
+/* Identifies testcase with parameters in history */
+static
+char* bake_test_history_key(
+    bake_test_exec_ctx *ctx,
+    bake_test_job *job)
+{
+    bake_test_suite_run *run = &ctx->runs[job->run];
+    bake_test_case *test = &run->suite->testcases[job->testcase];
+    return ut_asprintf("%s.%s%s", run->suite->id, test->id, run->params);
+}
+
+static
+void bake_test_history_set(
+    ut_rb history,
+    const char *testcase,
+    double duration)
+{
+    bake_test_history *h = ut_rb_find(history, testcase);
+    if (!h) {
+        h = ut_calloc(sizeof(bake_test_history));
+        h->testcase = ut_strdup(testcase);
+        h->duration = duration;
+        ut_rb_set(history, h->testcase, h);
+    } else {
+        /* Smooth out outliers, while still following trends */
+        h->duration = (h->duration + duration) / 2;
+    }
+}
+
+static
+ut_rb bake_test_history_load(void)
+{
+    ut_rb history = ut_rb_new(bake_test_history_compare, NULL);
+
+    if (ut_file_test(BAKE_TEST_HISTORY_FILE) != 1) {
+        ut_catch();
+        return history;
+    }
+
+    JSON_Value *json = json_parse_file(BAKE_TEST_HISTORY_FILE);
+    JSON_Object *root = json_value_get_object(json);
+    if (root) {
+        uint32_t i, count = json_object_get_count(root);
+        for (i = 0; i < count; i ++) {
+            bake_test_history_set(history, json_object_get_name(root, i),
+                json_value_get_number(json_object_get_value_at(root, i)));
+        }
+    } else {
+        /* Not fatal, history will be recreated */
+        ut_warning("ignoring corrupt test history '%s'", 
+            BAKE_TEST_HISTORY_FILE);
+    }
+
+    if (json) {
+        json_value_free(json);
+    }
+
+    return history;
+}
+
+static
+void bake_test_history_save(
+    bake_test_exec_ctx *ctx,
+    ut_rb history)
+{
+    uint32_t i;
+    for (i = 0; i < ctx->job_count; i ++) {
+        bake_test_job *job = &ctx->jobs[i];
+        char *key = bake_test_history_key(ctx, job);
+        bake_test_history_set(history, key, job->wall_time);
+        free(key);
+    }
+
+    if (ut_mkdir(".bake_cache")) {
+        ut_catch();
+        return;
+    }
+
+    FILE *f = fopen(BAKE_TEST_HISTORY_FILE, "w");
+    if (!f) {
+        ut_warning("failed to write '%s': %s", 
+            BAKE_TEST_HISTORY_FILE, strerror(errno));
+        return;
+    }
+
+    fprintf(f, "{");
+
+    bool first = true;
+    ut_iter it = ut_rb_iter(history);
+    while (ut_iter_hasNext(&it)) {
+        bake_test_history *h = ut_iter_next(&it);
+        fprintf(f, "%s\n  ", first ? "" : ",");
+        bake_test_json_str(f, h->testcase);
+        fprintf(f, ": %.6f", h->duration);
+        first = false;
+    }
+
+    fprintf(f, "\n}\n");
+    fclose(f);
+}
+
+static
+void bake_test_history_free(
+    ut_rb history)
+{
+    ut_iter it = ut_rb_iter(history);
+    while (ut_iter_hasNext(&it)) {
+        bake_test_history *h = ut_iter_next(&it);
+        free(h->testcase);
+        free(h);
+    }
+
+    ut_rb_free(history);
+}
+
+static
+int bake_test_compare_index(
+    const void *ptr1,
+    const void *ptr2)
+{
+    const bake_test_job *job1 = ptr1, *job2 = ptr2;
+    return (job1->index > job2->index) - (job1->index < job2->index);
+}
+
+static
+int bake_test_compare_expected_time(
+    const void *ptr1,
+    const void *ptr2)
+{
+    const bake_test_job *job1 = ptr1, *job2 = ptr2;
+
+    if (job1->expected_time < job2->expected_time) {
+        return 1;
+    } else if (job1->expected_time > job2->expected_time) {
+        return -1;
+    }
+
+    /* Keep declaration order for testcases with the same expected time */
+    return bake_test_compare_index(ptr1, ptr2);
+}
+
+/* Schedule the longest testcases first (LPT), so that no worker picks up a
+ * slow testcase at the end of the run while the others are idle. Testcases
+ * without history are expected to take the average time. */
+static
+void bake_test_schedule(
+    bake_test_exec_ctx *ctx,
+    ut_rb history)
+{
+    uint32_t i, known = 0;
+    double total = 0;
+
+    for (i = 0; i < ctx->job_count; i ++) {
+        bake_test_job *job = &ctx->jobs[i];
+        char *key = bake_test_history_key(ctx, job);
+        bake_test_history *h = ut_rb_find(history, key);
+        job->index = i;
+        job->expected_time = -1;
+        if (h) {
+            job->expected_time = h->duration;
+            total += h->duration;
+            known ++;
+        }
+        free(key);
+    }
+
+    if (!known) {
+        return;
+    }
+
+    for (i = 0; i < ctx->job_count; i ++) {
+        if (ctx->jobs[i].expected_time < 0) {
+            ctx->jobs[i].expected_time = total / known;
+        }
+    }
+
+    qsort(ctx->jobs, ctx->job_count, sizeof(bake_test_job), 
+        bake_test_compare_expected_time);
+}
+
+/* Only keep testcases of the current shard. Testcases are assigned round robin
+ * in declaration order, so that shards are disjoint, have the same size (plus
+ * or minus one) and are the same on every machine. */
+static
+void bake_test_shard(
+    bake_test_exec_ctx *ctx)
+{
+    uint32_t i, count = 0;
+
+    if (!test_shard_count) {
+        return;
+    }
+
+    for (i = 0; i < ctx->job_count; i ++) {
+        bake_test_job *job = &ctx->jobs[i];
+        if ((i % test_shard_count) == (test_shard_index - 1)) {
+            ctx->jobs[count ++] = *job;
         } else {
-            if (bake_test_run_suite_for_param(
-                test_id, exec, suite, &fail, &empty, &pass, job_count, 0))
-            {
-                result = -1;
-            }
+            ctx->runs[job->run].remaining --;
         }
+    }
 
-        if (empty || fail) {
-            ut_log("\n");
+    for (i = 0; i < ctx->run_count; i ++) {
+        bake_test_suite_run *run = &ctx->runs[i];
+        if (run->suite->testcase_count && !run->remaining) {
+            run->skip = true;
         }
+    }
+
+    ut_log("#[grey]shard %u/%u: running %u of %u testcases#[reset]\n", 
+        test_shard_index, test_shard_count, count, ctx->job_count);
+
+    ctx->job_count = count;
+}
+
+static
+int8_t bake_test_exec(
+    bake_test_exec_ctx *ctx,
+    uint32_t worker_count)
+{
+    uint32_t i;
+
+    if (worker_count > ctx->job_count) {
+        worker_count = ctx->job_count;
+    }
+
+    /* A prefix (like valgrind) must wrap every testcase process */
+    ctx->fork_server = test_fork_server && !ut_getenv("BAKE_TEST_PREFIX");
+
+#ifndef _WIN32
+    /* Don't exit when writing to a fork server that has stopped */
+    if (ctx->fork_server) {
+        signal(SIGPIPE, SIG_IGN);
+    }
+#endif
+
+    bake_test_shard(ctx);
+
+    ut_rb history = bake_test_history_load();
+    bake_test_schedule(ctx, history);
+
+    ut_mutex_new(&ctx->lock);
+
+    bake_test_report_start(ctx);
+
+    ut_thread *workers = ut_calloc(sizeof(ut_thread) * (worker_count + 1));
+    for (i = 0; i < worker_count; i ++) {
+        workers[i] = ut_thread_new((ut_thread_cb)bake_test_worker, ctx);
+    }
 
-        total_fail += fail;
-        total_empty += empty;
-        total_pass += pass;
+    for (i = 0; i < worker_count; i ++) {
+        ut_thread_join(workers[i], NULL);
     }
 
+    /* Report runs without testcases at the end */
+    bake_test_report_runs(ctx);
+    bake_test_report_stop(ctx);
+
+    /* Restore declaration order */
+    qsort(ctx->jobs, ctx->job_count, sizeof(bake_test_job), 
+        bake_test_compare_index);
+
+    bake_test_write_timing(ctx);
+    bake_test_history_save(ctx, history);
+    bake_test_history_free(history);
+
+    ut_mutex_free(&ctx->lock);
+    free(workers);
+
+    return ctx->result;
+}
+
+static
+void bake_test_exec_free(
+    bake_test_exec_ctx *ctx)
+{
+    uint32_t i;
+    for (i = 0; i < ctx->run_count; i ++) {
+        free(ctx->runs[i].params);
+        free(ctx->runs[i].param_str);
+    }
+
+    free(ctx->runs);
+    free(ctx->jobs);
+}
+
+static
+int8_t bake_test_run_suite(
+    const char *test_id,
+    const char *exec,
+    bake_test_suite *suite,
+    uint32_t job_count)
+{
+    assert(test_id != NULL);
+    assert(exec != NULL);
+    assert(strlen(exec) != 0);
+
+    bake_test_exec_ctx ctx = {
+        .test_project = test_id,
+        .exec = exec
+    };
+
+    bake_test_add_run(&ctx, suite);
+
+    int8_t result = bake_test_exec(&ctx, job_count);
+
+    bake_test_report_slowest(&ctx);
+    bake_test_exec_free(&ctx);
+
+    return result;
+}
+
+static
+int8_t bake_test_run_all_tests(
+    const char *test_id,
+    const char *exec,
+    bake_test_suite *suites,
+    uint32_t suite_count,
+    uint32_t job_count)
+{
+    bake_test_exec_ctx ctx = {
+        .test_project = test_id,
+        .exec = exec,
+        .all_suites = true
+    };
+
+    uint32_t i;
+    for (i = 0; i < suite_count; i ++) {
+        bake_test_add_param_runs(&ctx, &suites[i], 0);
+    }
+
+    ut_log("\n");
+
+    int8_t result = bake_test_exec(&ctx, job_count);
+
     ut_log("-----------------------------\n");
-    bake_test_report(test_id, "all", "", total_fail, total_empty, total_pass);
+    bake_test_report(test_id, "all", "", ctx.fail, ctx.empty, ctx.pass);
     ut_log("\n");
 
+    bake_test_report_slowest(&ctx);
+    bake_test_exec_free(&ctx);
+
     return result;
 }
 
@@ -594,6 +1663,8 @@ int bake_test_run(
     const char *single_test = NULL;
     bake_test_suite *suite = NULL;
     int32_t job_count = 0;
+    int fork_server_fd = -1, fork_server_response_fd = -1;
+    const char *shard = ut_getenv("BAKE_TEST_SHARD");
 
     ut_init(test_id);
 
@@ -622,6 +1693,45 @@ int bake_test_run(
                     }
                     bake_add_param(argv[i + 1]);
                     i ++;
+                } else if (!strcmp(arg, "--slowest")) {
+                    if (!argv[i + 1]) {
+                        ut_error("missing argument for --slowest");
+                        abort();
+                    }
+                    test_slowest_count = atoi(argv[i + 1]);
+                    i ++;
+                } else if (!strcmp(arg, "--shard")) {
+                    if (!argv[i + 1]) {
+                        ut_error("missing argument for --shard");
+                        abort();
+                    }
+                    shard = argv[i + 1];
+                    i ++;
+                } else if (!strcmp(arg, "--report-json")) {
+                    if (!argv[i + 1]) {
+                        ut_error("missing argument for --report-json");
+                        abort();
+                    }
+                    test_report_json = argv[i + 1];
+                    i ++;
+                } else if (!strcmp(arg, "--report-junit")) {
+                    if (!argv[i + 1]) {
+                        ut_error("missing argument for --report-junit");
+                        abort();
+                    }
+                    test_report_junit = argv[i + 1];
+                    i ++;
+                } else if (!strcmp(arg, "--no-fork-server")) {
+                    test_fork_server = false;
+
+                } else if (!strcmp(arg, "--fork-server")) {
+                    if (!argv[i + 1] || !argv[i + 2]) {
+                        ut_error("missing arguments for --fork-server");
+                        abort();
+                    }
+                    fork_server_fd = atoi(argv[i + 1]);
+                    fork_server_response_fd = atoi(argv[i + 2]);
+                    i += 2;
                 } else {
                     ut_error("invalid argument for test executable", arg);
                     abort();
@@ -649,16 +1759,46 @@ int bake_test_run(
     }
 
     if (!job_count) {
+        /* Set by bake test when projects are tested in parallel */
+        const char *env_jobs = ut_getenv("BAKE_TEST_JOBS");
+        if (env_jobs) {
+            job_count = atoi(env_jobs);
+        }
+    }
+
+    if (job_count <= 0) {
         job_count = 8; /* run on 8 threads by default */
     }
 
+    /* Set by bake test, which can test multiple projects with the same report
+     * locations */
+    if (!test_report_json && !test_report_junit) {
+        test_report_json = ut_getenv("BAKE_TEST_REPORT_JSON");
+        test_report_junit = ut_getenv("BAKE_TEST_REPORT_JUNIT");
+        test_report_per_project = test_report_json || test_report_junit;
+    }
+
+    if (shard && !single_test && fork_server_fd == -1) {
+        if (sscanf(shard, "%u/%u", &test_shard_index, &test_shard_count) != 2 ||
+            !test_shard_index || test_shard_index > test_shard_count)
+        {
+            ut_error("invalid shard '%s' (expected index/count, starting "
+                "from 1/count)", shard);
+            abort();
+        }
+    }
+
     int result = 0;
 
-    if (single_test) {
+    if (fork_server_fd != -1) {
+#ifndef _WIN32
+        result = bake_test_fork_server(
+            suites, suite_count, fork_server_fd, fork_server_response_fd);
+#endif
+    } else if (single_test) {
         result = bake_test_run_single_test(suites, suite_count, argv[1]);
     } else if (suite) {
-        result = bake_test_run_suite(
-            test_id, argv[0], suite, NULL, NULL, NULL, job_count);
+        result = bake_test_run_suite(test_id, argv[0], suite, job_count);
     } else {
         result = bake_test_run_all_tests(
             test_id, argv[0], suites, suite_count, job_count);
@@ -698,7 +1838,7 @@ void test_fail(
 
 static 
 void test_exit(void) {
-    exit(!test_flaky * -1);
+    exit(test_flaky ? BAKE_TEST_RC_FLAKY : -1);
 }
 
 bool _if_test_assert(
@@ -1084,5 +2224,5 @@ void test_is_flaky(void) {
 void test_quarantine(const char *date) {
     ut_log("#[yellow]SKIP#[reset]: %s.%s: test was quarantined on %s\n", 
         current_testsuite->id, current_testcase->id, date);
-    exit(0);
+    exit(BAKE_TEST_RC_QUARANTINED);
 }
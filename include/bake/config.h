@@ -63,6 +63,9 @@ struct bake_config {
     bool sanitize_undefined;    /* Enable UB sanitizier (if supported) */
     bool loop_test;             /* Enable analysis for SIMD loops */
     bool assembly;              /* Enable assembly output */
+    uint32_t jobs;              /* Number of projects/files to build in parallel */
+    bool object_cache;          /* Reuse objects from $BAKE_HOME/cache/obj */
+    uint32_t object_cache_size; /* Maximum size of object cache (in MB, 0 = no limit) */
 
     /* Environment attribubtes */
     ut_ll env_variables;        /* List with environment variable names */
@@ -88,6 +91,10 @@ struct bake_config {
 
     time_t bake_modified;    /* Used to determine whether code should be
                               * regenerated after bake is upgraded. */
+
+    /* Set by drivers that use the object cache */
+    uint32_t object_cache_hits;
+    uint32_t object_cache_misses;
 };
 
 #ifdef __cplusplus
@@ -67,7 +67,19 @@ void (*bake_rule_action_cb)(
     char *src,
     char *target);
 
-/** Map rule callback */
+/** Command callback of a rule. Returns the command the action executes for a
+ * source and target, without executing it. */
+typedef
+char* (*bake_rule_command_cb)(
+    bake_driver_api *driver,
+    bake_config *config,
+    bake_project *project,
+    const char *src,
+    const char *target);
+
+/** Map rule callback. Returns NULL without raising an error if the input
+ * should not be mapped to a target, like a source file that is compiled as part
+ * of another source file. */
 typedef
 char* (*bake_rule_map_cb)(
     bake_driver_api *driver,
@@ -114,7 +126,8 @@ typedef struct bake_rule_target {
 typedef enum bake_rule_kind {
     BAKE_RULE_PATTERN,
     BAKE_RULE_RULE,
-    BAKE_RULE_FILE
+    BAKE_RULE_FILE,
+    BAKE_RULE_DEPENDENCY
 } bake_rule_kind;
 
 /* The driver API is a struct that is passed to the bakemain function, which is
@@ -159,7 +172,10 @@ struct bake_driver_api {
         bake_rule_target target,
         bake_rule_action_cb action);
 
-    /* Create a dependency rule */
+    /* Create a dependency rule. The deps argument specifies the map rule (as
+     * "$rule") for which dependencies are loaded. The mapping translates a
+     * target of that rule to a make-style dependency file. If the action is
+     * set, it is invoked to create a dependency file that does not exist. */
     void (*dependency_rule)(
         const char *name,
         const char *deps,
@@ -183,6 +199,12 @@ struct bake_driver_api {
         const char *name,
         bake_condition_cb cond);
 
+    /* Set callback that returns the command of a map rule. Targets are rebuilt
+     * when the command changes since the last build. */
+    void (*command)(
+        const char *name,
+        bake_rule_command_cb command);
+
     /* Callback to initialize a driver before building the project */
     void (*init)(
         bake_driver_cb action);
@@ -235,6 +257,18 @@ struct bake_driver_api {
     void (*exec)(
         const char *cmd);
 
+    /* Test if target built by a command must be rebuilt, because it does not
+     * exist, the command changed or a file in its dependency file changed */
+    bool (*target_outdated)(
+        const char *target,
+        const char *dep_file,
+        const char *cmd);
+
+    /* Record command that built target, for target_outdated */
+    void (*target_built)(
+        const char *target,
+        const char *cmd);
+
     /* Add dependency */
     void (*use)(
         const char *id);
@@ -138,6 +138,138 @@ int bake_do_install(
     bake_project *p);
 
 
+/* -- Build daemon -- */
+
+/** Build callback invoked by daemon for a client request. Rediscover is true
+ * when projects must be discovered again, as the directory tree changed. */
+typedef int16_t (*bake_daemon_build_cb)(
+    bake_config *config,
+    const char *action,
+    bool rediscover);
+
+/** Run daemon that builds projects in path on request of clients */
+int16_t bake_daemon_run(
+    bake_config *config,
+    const char *path,
+    const char *signature,
+    bake_daemon_build_cb build);
+
+/** Request daemon for path to run action. Returns -1 if no daemon is running
+ * for the path or if the daemon rejected the request, otherwise the return code
+ * of the build. */
+int bake_daemon_request(
+    const char *path,
+    const char *action,
+    const char *signature);
+
+/* -- Build database -- */
+
+typedef struct bake_builddb bake_builddb;
+
+/** Load build database of project for current target and configuration */
+bake_builddb* bake_builddb_load(
+    bake_config *config,
+    bake_project *project);
+
+/** Write build database to disk */
+int16_t bake_builddb_save(
+    bake_builddb *db);
+
+/** Free build database */
+void bake_builddb_free(
+    bake_builddb *db);
+
+/** Test if contents of inputs are the same as when target was built */
+bool bake_builddb_inputs_unchanged(
+    bake_builddb *db,
+    const char *target,
+    ut_ll inputs);
+
+/** Record inputs used to build target */
+void bake_builddb_set(
+    bake_builddb *db,
+    const char *target,
+    ut_ll inputs);
+
+/* -- Changed projects -- */
+
+/** Test if project, its tests or one of its dependencies changed since the
+ * tests of the project last passed */
+bool bake_changes_test_outdated(
+    bake_config *config,
+    bake_project *project);
+
+/** Record state of project and its dependencies after tests passed */
+int16_t bake_changes_test_passed(
+    bake_config *config,
+    bake_project *project);
+
+/* -- Project metadata cache -- */
+
+/** Get copy of parsed project.json of project in path */
+JSON_Value* bake_metadata_json(
+    const char *path);
+
+/** Get project in path for reading dependency information. The project is
+ * owned by the cache and must not be modified. */
+bake_project* bake_metadata_project(
+    bake_config *config,
+    const char *path);
+
+/** Get parsed dependee.json of project in path. Sets dependee_out to NULL if
+ * the project has no dependee.json. */
+int16_t bake_metadata_dependee(
+    const char *path,
+    JSON_Object **dependee_out);
+
+/** Remove cached files of project in path */
+void bake_metadata_invalidate(
+    const char *path);
+
+/* -- Jobs -- */
+
+typedef struct bake_jobs bake_jobs;
+
+typedef int16_t (*bake_job_cb)(
+    void *ctx);
+
+/** Start worker threads.
+ * While workers are running, jobs may run in parallel. Only one job at a time
+ * runs bake code. A job lets other jobs run while it waits for a process. */
+void bake_jobs_start(
+    uint32_t count);
+
+/** Stop worker threads */
+void bake_jobs_stop(void);
+
+/** Create a set of jobs.
+ * Jobs inherit the driver, project, configuration and log capture buffer of
+ * the thread that creates the set. */
+bake_jobs* bake_jobs_new(void);
+
+/** Add job to set. May be invoked from a running job. */
+void bake_jobs_add(
+    bake_jobs *jobs,
+    bake_job_cb action,
+    void *ctx);
+
+/** Run jobs in set, wait until all have finished and free the set.
+ * Returns -1 if any of the jobs failed. */
+int16_t bake_jobs_wait(
+    bake_jobs *jobs);
+
+/** Allow other jobs to run while the current job waits for a process.
+ * Returns false if the current job cannot be suspended. */
+bool bake_jobs_suspend(void);
+
+/** Resume the current job after a successful bake_jobs_suspend */
+void bake_jobs_resume(void);
+
+/** Add output of a process that was redirected to a file to the log captured
+ * for the current job, or print it if the log is not captured. Closes out. */
+void bake_jobs_output(
+    FILE *out);
+
 /* -- Run project -- */
 
 int bake_run(
@@ -415,6 +547,7 @@ typedef struct bake_rule {
     const char *source;     /* Source pattern */
     bake_rule_target target;      /* Rule target (MAP or PATTERN) */
     bake_rule_action_cb action;   /* Action to execute for rule */
+    bake_rule_command_cb command; /* Command executed by action (optional) */
 } bake_rule;
 
 /** Dependency rule
@@ -466,6 +599,19 @@ int16_t bake_node_eval(
     bake_filelist *inherits,
     bake_filelist *outputs);
 
+/** Test if target must be rebuilt. This is the case when the target does not
+ * exist, when it was built with a different command, or when a file in its
+ * make-style dependency file changed. */
+bool bake_node_target_outdated(
+    const char *target,
+    const char *dep_file,
+    const char *cmd);
+
+/** Record command that built target */
+void bake_node_target_built(
+    const char *target,
+    const char *cmd);
+
 
 /* Attribute API */
 
@@ -496,6 +642,12 @@ int16_t bake_json_set_boolean(
     const char *member,
     JSON_Value *v);
 
+/** Set unsigned integer value from JSON value */
+int16_t bake_json_set_uint32(
+    uint32_t *ptr,
+    const char *member,
+    JSON_Value *v);
+
 /** Set string value from JSON value */
 int16_t bake_json_set_string(
     char **ptr,
@@ -80,6 +80,9 @@ error:
     return -1;
 }
 
+/* Number of projects that are currently being built */
+static int32_t bake_building = 0;
+
 /* At this stage, the project configuration is fully loaded (including dependee
  * configuration), and all dependencies are built or found in the bake env. */
 static
@@ -100,8 +103,11 @@ int bake_do_build_intern(
     /* If any of the steps invoke bake, they may invoke the bake script, which
      * can reset the LD_LIBRARY_PATH environment variable. Setting this variable
      * to false will cause bake to fork itself again after the environment is
-     * set correctly. */
-    ut_setenv("BAKE_CHILD", "FALSE");
+     * set correctly. Projects may be built in parallel, so only reset the
+     * variable once the last project has finished. */
+    if (!bake_building ++) {
+        ut_setenv("BAKE_CHILD", "FALSE");
+    }
 
     /* Step 5: if rebuilding, clean project cache for current platform/config */
     if (rebuild) {
@@ -174,10 +180,15 @@ int bake_do_build_intern(
     ut_log_pop();
 
     /* Reset environment variable */
-    ut_setenv("BAKE_CHILD", "TRUE");
+    if (!-- bake_building) {
+        ut_setenv("BAKE_CHILD", "TRUE");
+    }
 
     return (project->error == true) * -1;
 error:
+    if (!-- bake_building) {
+        ut_setenv("BAKE_CHILD", "TRUE");
+    }
     ut_log_pop();
     return -1;
 }
@@ -0,0 +1,438 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bake.h"
+
+/* The build database stores a hash of the contents of input files, and the
+ * inputs that were used to build a target. This allows bake to skip actions
+ * for inputs that have a newer timestamp, but the same contents (after a git
+ * checkout, for example). */
+
+#define BAKE_BUILDDB_FILE "builddb.json"
+
+/* Hash of a file. The hash is recomputed when the timestamp changes */
+typedef struct bake_builddb_file {
+    char *path;
+    time_t mtime;
+    uint64_t hash;
+    bool used;
+} bake_builddb_file;
+
+/* Input of a target, with the hash of the input when target was built */
+typedef struct bake_builddb_input {
+    char *path;
+    uint64_t hash;
+} bake_builddb_input;
+
+typedef struct bake_builddb_target {
+    char *path;
+    ut_ll inputs;
+} bake_builddb_target;
+
+struct bake_builddb {
+    char *file;
+    char *project_path;
+    ut_rb files;
+    ut_rb targets;
+};
+
+static
+int bake_builddb_compare(
+    void *ctx,
+    const void* key1,
+    const void* key2)
+{
+    return strcmp(key1, key2);
+}
+
+/* Paths are stored relative to the project, so that the database remains
+ * valid when bake is invoked from another directory. */
+static
+const char* bake_builddb_key(
+    bake_builddb *db,
+    const char *path)
+{
+    size_t len = strlen(db->project_path);
+
+    if (!strncmp(path, db->project_path, len) && path[len] == UT_OS_PS[0]) {
+        path += len + 1;
+    }
+
+    while (path[0] == '.' && path[1] == UT_OS_PS[0]) {
+        path += 2;
+    }
+
+    return path;
+}
+
+static
+bake_builddb_file* bake_builddb_file_get(
+    bake_builddb *db,
+    const char *path)
+{
+    const char *key = bake_builddb_key(db, path);
+    bake_builddb_file *file = ut_rb_find(db->files, key);
+    time_t mtime = ut_lastmodified(path);
+
+    if (mtime == -1) {
+        ut_catch();
+        return NULL;
+    }
+
+    if (!file) {
+        file = ut_calloc(sizeof(bake_builddb_file));
+        file->path = ut_strdup(key);
+        ut_rb_set(db->files, file->path, file);
+    } else if (file->mtime == mtime) {
+        file->used = true;
+        return file;
+    }
+
+    if (ut_file_hash(path, &file->hash)) {
+        ut_catch();
+        ut_rb_remove(db->files, file->path);
+        free(file->path);
+        free(file);
+        return NULL;
+    }
+
+    file->mtime = mtime;
+    file->used = true;
+
+    return file;
+}
+
+static
+void bake_builddb_target_free(
+    bake_builddb_target *target)
+{
+    if (target->inputs) {
+        bake_builddb_input *input;
+        while ((input = ut_ll_takeFirst(target->inputs))) {
+            free(input->path);
+            free(input);
+        }
+        ut_ll_free(target->inputs);
+    }
+    free(target->path);
+    free(target);
+}
+
+static
+uint64_t bake_builddb_parse_hash(
+    const char *str)
+{
+    return str ? strtoull(str, NULL, 16) : 0;
+}
+
+static
+void bake_builddb_parse(
+    bake_builddb *db,
+    JSON_Object *root)
+{
+    uint32_t i, count;
+
+    JSON_Object *files = json_object_get_object(root, "files");
+    count = json_object_get_count(files);
+    for (i = 0; i < count; i ++) {
+        JSON_Object *obj = json_value_get_object(
+            json_object_get_value_at(files, i));
+        if (!obj) {
+            continue;
+        }
+
+        bake_builddb_file *file = ut_calloc(sizeof(bake_builddb_file));
+        file->path = ut_strdup(json_object_get_name(files, i));
+        file->mtime = json_object_get_number(obj, "mtime");
+        file->hash = bake_builddb_parse_hash(
+            json_object_get_string(obj, "hash"));
+        ut_rb_set(db->files, file->path, file);
+    }
+
+    JSON_Object *targets = json_object_get_object(root, "targets");
+    count = json_object_get_count(targets);
+    for (i = 0; i < count; i ++) {
+        JSON_Object *obj = json_value_get_object(
+            json_object_get_value_at(targets, i));
+        if (!obj) {
+            continue;
+        }
+
+        bake_builddb_target *target = ut_calloc(sizeof(bake_builddb_target));
+        target->path = ut_strdup(json_object_get_name(targets, i));
+        target->inputs = ut_ll_new();
+
+        JSON_Object *inputs = json_object_get_object(obj, "inputs");
+        uint32_t j, input_count = json_object_get_count(inputs);
+        for (j = 0; j < input_count; j ++) {
+            bake_builddb_input *input = ut_calloc(sizeof(bake_builddb_input));
+            input->path = ut_strdup(json_object_get_name(inputs, j));
+            input->hash = bake_builddb_parse_hash(json_value_get_string(
+                json_object_get_value_at(inputs, j)));
+            ut_ll_append(target->inputs, input);
+        }
+
+        ut_rb_set(db->targets, target->path, target);
+    }
+}
+
+bake_builddb* bake_builddb_load(
+    bake_config *config,
+    bake_project *project)
+{
+    bake_builddb *db = ut_calloc(sizeof(bake_builddb));
+    db->file = ut_asprintf("%s"UT_OS_PS"%s-%s"UT_OS_PS BAKE_BUILDDB_FILE,
+        project->cache_path, config->build_target, config->configuration);
+    db->project_path = ut_strdup(project->path);
+    db->files = ut_rb_new(bake_builddb_compare, NULL);
+    db->targets = ut_rb_new(bake_builddb_compare, NULL);
+
+    if (ut_file_test(db->file) == 1) {
+        JSON_Value *json = json_parse_file(db->file);
+        JSON_Object *root = json_value_get_object(json);
+        if (root) {
+            bake_builddb_parse(db, root);
+        } else {
+            /* Not fatal, database will be recreated */
+            ut_warning("ignoring corrupt build database '%s'", db->file);
+        }
+
+        if (json) {
+            json_value_free(json);
+        }
+    }
+
+    return db;
+}
+
+static
+void bake_builddb_hash_str(
+    uint64_t hash,
+    char *buf)
+{
+    sprintf(buf, "%016"PRIx64, hash);
+}
+
+int16_t bake_builddb_save(
+    bake_builddb *db)
+{
+    char hash[17];
+    JSON_Value *json = json_value_init_object();
+    JSON_Object *root = json_value_get_object(json);
+
+    JSON_Value *targets_value = json_value_init_object();
+    JSON_Object *targets = json_value_get_object(targets_value);
+    json_object_set_value(root, "targets", targets_value);
+
+    ut_iter it = ut_rb_iter(db->targets);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_target *target = ut_iter_next(&it);
+        JSON_Value *target_value = json_value_init_object();
+        JSON_Object *target_obj = json_value_get_object(target_value);
+        JSON_Value *inputs_value = json_value_init_object();
+        JSON_Object *inputs = json_value_get_object(inputs_value);
+
+        ut_iter input_it = ut_ll_iter(target->inputs);
+        while (ut_iter_hasNext(&input_it)) {
+            bake_builddb_input *input = ut_iter_next(&input_it);
+            bake_builddb_file *file = ut_rb_find(db->files, input->path);
+            if (file) {
+                file->used = true;
+            }
+            bake_builddb_hash_str(input->hash, hash);
+            json_object_set_string(inputs, input->path, hash);
+        }
+
+        json_object_set_value(target_obj, "inputs", inputs_value);
+        json_object_set_value(targets, target->path, target_value);
+    }
+
+    /* Only store hashes of files that are still used */
+    JSON_Value *files_value = json_value_init_object();
+    JSON_Object *files = json_value_get_object(files_value);
+    json_object_set_value(root, "files", files_value);
+
+    it = ut_rb_iter(db->files);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_file *file = ut_iter_next(&it);
+        if (!file->used) {
+            continue;
+        }
+
+        JSON_Value *file_value = json_value_init_object();
+        JSON_Object *file_obj = json_value_get_object(file_value);
+        json_object_set_number(file_obj, "mtime", file->mtime);
+        bake_builddb_hash_str(file->hash, hash);
+        json_object_set_string(file_obj, "hash", hash);
+        json_object_set_value(files, file->path, file_value);
+    }
+
+    char *dir = ut_path_dirname(db->file);
+    if (ut_mkdir(dir)) {
+        free(dir);
+        goto error;
+    }
+    free(dir);
+
+    json_set_escape_slashes(0);
+
+    if (json_serialize_to_file(json, db->file) != JSONSuccess) {
+        ut_throw("failed to write build database '%s'", db->file);
+        goto error;
+    }
+
+    json_value_free(json);
+
+    return 0;
+error:
+    json_value_free(json);
+    return -1;
+}
+
+void bake_builddb_free(
+    bake_builddb *db)
+{
+    ut_iter it = ut_rb_iter(db->files);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_file *file = ut_iter_next(&it);
+        free(file->path);
+        free(file);
+    }
+
+    it = ut_rb_iter(db->targets);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_target *target = ut_iter_next(&it);
+        bake_builddb_target_free(target);
+    }
+
+    ut_rb_free(db->files);
+    ut_rb_free(db->targets);
+    free(db->project_path);
+    free(db->file);
+    free(db);
+}
+
+static
+bake_builddb_input* bake_builddb_input_find(
+    ut_ll inputs,
+    const char *key)
+{
+    ut_iter it = ut_ll_iter(inputs);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_input *input = ut_iter_next(&it);
+        if (!strcmp(input->path, key)) {
+            return input;
+        }
+    }
+
+    return NULL;
+}
+
+bool bake_builddb_inputs_unchanged(
+    bake_builddb *db,
+    const char *target_path,
+    ut_ll inputs)
+{
+    bake_builddb_target *target = ut_rb_find(
+        db->targets, bake_builddb_key(db, target_path));
+    if (!target) {
+        return false;
+    }
+
+    /* Every input must have been recorded with the same hash */
+    ut_iter it = ut_ll_iter(inputs);
+    while (ut_iter_hasNext(&it)) {
+        const char *path = ut_iter_next(&it);
+        bake_builddb_input *input = bake_builddb_input_find(
+            target->inputs, bake_builddb_key(db, path));
+        if (!input) {
+            return false;
+        }
+
+        bake_builddb_file *file = bake_builddb_file_get(db, path);
+        if (!file || file->hash != input->hash) {
+            return false;
+        }
+    }
+
+    /* Every recorded input must still be an input. Inputs may be listed more
+     * than once (a depfile also lists the source). */
+    it = ut_ll_iter(target->inputs);
+    while (ut_iter_hasNext(&it)) {
+        bake_builddb_input *input = ut_iter_next(&it);
+        bool found = false;
+
+        ut_iter input_it = ut_ll_iter(inputs);
+        while (ut_iter_hasNext(&input_it)) {
+            const char *path = ut_iter_next(&input_it);
+            if (!strcmp(bake_builddb_key(db, path), input->path)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void bake_builddb_set(
+    bake_builddb *db,
+    const char *target_path,
+    ut_ll inputs)
+{
+    const char *key = bake_builddb_key(db, target_path);
+    bake_builddb_target *target = ut_rb_find(db->targets, key);
+    if (target) {
+        ut_rb_remove(db->targets, (void*)key);
+        bake_builddb_target_free(target);
+    }
+
+    target = ut_calloc(sizeof(bake_builddb_target));
+    target->path = ut_strdup(key);
+    target->inputs = ut_ll_new();
+
+    ut_iter it = ut_ll_iter(inputs);
+    while (ut_iter_hasNext(&it)) {
+        const char *path = ut_iter_next(&it);
+        bake_builddb_file *file = bake_builddb_file_get(db, path);
+        if (!file) {
+            /* If an input can't be hashed, don't store the target, so that
+             * it is never considered unchanged */
+            bake_builddb_target_free(target);
+            return;
+        }
+
+        if (bake_builddb_input_find(target->inputs, file->path)) {
+            continue;
+        }
+
+        bake_builddb_input *input = ut_calloc(sizeof(bake_builddb_input));
+        input->path = ut_strdup(file->path);
+        input->hash = file->hash;
+        ut_ll_append(target->inputs, input);
+    }
+
+    ut_rb_set(db->targets, target->path, target);
+}
@@ -0,0 +1,264 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bake.h"
+
+/* Tracks which projects changed since the tests of a project last passed. When
+ * the tests of a project pass, a fingerprint of the project, its tests and of
+ * each of its (transitive) dependencies is stored in the project cache. Tests
+ * only need to run again if one of the fingerprints changed.
+ *
+ * Fingerprints are computed from file contents rather than timestamps, as
+ * bake rewrites generated files (like bake_config.h) on every build. As this
+ * reads all files of a project, fingerprints are only computed and stored when
+ * testing with --changed. */
+
+#define BAKE_CHANGES_FILE "test_state.json"
+#define BAKE_CHANGES_TEST_KEY "/test"
+
+typedef struct bake_changes_fingerprint {
+    char *key;
+    uint64_t hash;
+} bake_changes_fingerprint;
+
+/* Fingerprints are computed once per bake invocation */
+static ut_rb bake_changes_fingerprints;
+
+static
+int bake_changes_compare(
+    void *ctx,
+    const void* key1,
+    const void* key2)
+{
+    return strcmp(key1, key2);
+}
+
+/* Combine hashes of files in directory. Hidden files, binaries and nested
+ * projects (such as the test project) are not part of the fingerprint. */
+static
+uint64_t bake_changes_hash_dir(
+    const char *path,
+    const char *rel_path)
+{
+    uint64_t result = 0;
+    ut_iter it;
+
+    if (ut_dir_iter(path, NULL, &it)) {
+        ut_catch();
+        return 0;
+    }
+
+    while (ut_iter_hasNext(&it)) {
+        char *name = ut_iter_next(&it);
+        if (name[0] == '.' || !strcmp(name, "bin")) {
+            continue;
+        }
+
+        char *file = ut_asprintf("%s"UT_OS_PS"%s", path, name);
+        char *rel_file = rel_path[0]
+            ? ut_asprintf("%s/%s", rel_path, name)
+            : ut_strdup(name);
+
+        if (ut_isdir(file)) {
+            char *project_json = ut_asprintf(
+                "%s"UT_OS_PS"project.json", file);
+            if (ut_file_test(project_json) != 1) {
+                result += bake_changes_hash_dir(file, rel_file);
+            }
+            free(project_json);
+        } else {
+            uint64_t hash, content = 0;
+            if (ut_file_hash(file, &content)) {
+                ut_catch();
+            }
+
+            /* Files are combined with addition, so that the fingerprint does
+             * not depend on the order in which files are listed */
+            hash = ut_hash_str(UT_HASH_INIT, rel_file);
+            hash = ut_hash_buf(hash, &content, sizeof(content));
+            result += hash;
+        }
+
+        free(rel_file);
+        free(file);
+    }
+
+    ut_catch();
+
+    return result;
+}
+
+static
+uint64_t bake_changes_fingerprint_get(
+    const char *key,
+    const char *path)
+{
+    if (!bake_changes_fingerprints) {
+        bake_changes_fingerprints = ut_rb_new(bake_changes_compare, NULL);
+    }
+
+    bake_changes_fingerprint *fp = ut_rb_find(bake_changes_fingerprints, key);
+    if (!fp) {
+        fp = ut_calloc(sizeof(bake_changes_fingerprint));
+        fp->key = ut_strdup(key);
+        fp->hash = bake_changes_hash_dir(path, "");
+        ut_rb_set(bake_changes_fingerprints, fp->key, fp);
+    }
+
+    return fp->hash;
+}
+
+static
+void bake_changes_collect_list(
+    ut_rb projects,
+    ut_ll list);
+
+/* Collect project and its transitive dependencies. Dependencies that are not
+ * discovered by the crawler are not tracked. */
+static
+void bake_changes_collect(
+    ut_rb projects,
+    bake_project *project)
+{
+    if (!project->path || ut_rb_find(projects, project->id)) {
+        return;
+    }
+
+    ut_rb_set(projects, project->id, project);
+
+    bake_changes_collect_list(projects, project->use);
+    bake_changes_collect_list(projects, project->use_private);
+    bake_changes_collect_list(projects, project->use_build);
+    bake_changes_collect_list(projects, project->use_runtime);
+}
+
+static
+void bake_changes_collect_list(
+    ut_rb projects,
+    ut_ll list)
+{
+    if (list) {
+        ut_iter it = ut_ll_iter(list);
+        while (ut_iter_hasNext(&it)) {
+            bake_project *dep = bake_crawler_get(ut_iter_next(&it));
+            if (dep) {
+                bake_changes_collect(projects, dep);
+            }
+        }
+    }
+}
+
+/* Create object with current fingerprints of project, tests and dependencies */
+static
+JSON_Value* bake_changes_state(
+    bake_project *project,
+    bool *freshly_baked_out)
+{
+    JSON_Value *json = json_value_init_object();
+    JSON_Object *root = json_value_get_object(json);
+    ut_rb projects = ut_rb_new(bake_changes_compare, NULL);
+    char hash[17];
+
+    bake_changes_collect(projects, project);
+
+    ut_iter it = ut_rb_iter(projects);
+    while (ut_iter_hasNext(&it)) {
+        bake_project *p = ut_iter_next(&it);
+        sprintf(hash, "%016"PRIx64,
+            bake_changes_fingerprint_get(p->id, p->path));
+        json_object_set_string(root, p->id, hash);
+
+        if (p->freshly_baked && freshly_baked_out) {
+            *freshly_baked_out = true;
+        }
+    }
+
+    char *test_key = ut_asprintf("%s"BAKE_CHANGES_TEST_KEY, project->id);
+    char *test_path = ut_asprintf("%s"UT_OS_PS"test", project->path);
+    sprintf(hash, "%016"PRIx64,
+        bake_changes_fingerprint_get(test_key, test_path));
+    json_object_set_string(root, test_key, hash);
+    free(test_path);
+    free(test_key);
+
+    ut_rb_free(projects);
+
+    return json;
+}
+
+bool bake_changes_test_outdated(
+    bake_config *config,
+    bake_project *project)
+{
+    bool result = false;
+    char *file = ut_asprintf(
+        "%s"UT_OS_PS BAKE_CHANGES_FILE, project->cache_path);
+
+    JSON_Value *state = bake_changes_state(project, &result);
+    JSON_Value *stored = NULL;
+
+    if (result || ut_file_test(file) != 1) {
+        result = true;
+        goto done;
+    }
+
+    stored = json_parse_file(file);
+    if (!stored || !json_value_equals(state, stored)) {
+        result = true;
+    }
+
+done:
+    if (stored) {
+        json_value_free(stored);
+    }
+    json_value_free(state);
+    free(file);
+    ut_catch();
+    return result;
+}
+
+int16_t bake_changes_test_passed(
+    bake_config *config,
+    bake_project *project)
+{
+    char *file = ut_asprintf(
+        "%s"UT_OS_PS BAKE_CHANGES_FILE, project->cache_path);
+    JSON_Value *state = bake_changes_state(project, NULL);
+
+    if (ut_mkdir(project->cache_path)) {
+        goto error;
+    }
+
+    json_set_escape_slashes(0);
+
+    if (json_serialize_to_file(state, file) != JSONSuccess) {
+        ut_throw("failed to write test state '%s'", file);
+        goto error;
+    }
+
+    json_value_free(state);
+    free(file);
+    return 0;
+error:
+    json_value_free(state);
+    free(file);
+    return -1;
+}
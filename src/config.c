@@ -196,6 +196,8 @@ error:
 #define CFG_SANITIZE_UNDEFINED "sanitize-undefined"
 #define CFG_LOOP_TEST "loop-test"
 #define CFG_ASSEMBLY "assembly"
+#define CFG_OBJECT_CACHE "object-cache"
+#define CFG_OBJECT_CACHE_SIZE "object-cache-size"
 
 static
 int16_t bake_config_loadConfiguration(
@@ -251,6 +253,14 @@ int16_t bake_config_loadConfiguration(
             if (bake_json_set_boolean(&cfg_out->assembly, CFG_ASSEMBLY, value)) {
                 goto error;
             }
+        } else if (strcmp(json_name, CFG_OBJECT_CACHE) == 0) {
+            if (bake_json_set_boolean(&cfg_out->object_cache, CFG_OBJECT_CACHE, value)) {
+                goto error;
+            }
+        } else if (strcmp(json_name, CFG_OBJECT_CACHE_SIZE) == 0) {
+            if (bake_json_set_uint32(&cfg_out->object_cache_size, CFG_OBJECT_CACHE_SIZE, value)) {
+                goto error;
+            }
         }
     }
     ut_log_pop();
@@ -699,6 +709,8 @@ void bake_config_log(
         ut_trace("set '%s' to '%s'", CFG_SANITIZE_UNDEFINED, cfg->sanitize_undefined ? "true" : "false");
         ut_trace("set '%s' to '%s'", CFG_LOOP_TEST, cfg->loop_test ? "true" : "false");
         ut_trace("set '%s' to '%s'", CFG_ASSEMBLY, cfg->assembly ? "true" : "false");
+        ut_trace("set '%s' to '%s'", CFG_OBJECT_CACHE, cfg->object_cache ? "true" : "false");
+        ut_trace("set '%s' to '%u'", CFG_OBJECT_CACHE_SIZE, cfg->object_cache_size);
         ut_log_pop();
     }
 }
@@ -738,6 +750,7 @@ int16_t bake_config_export(
             "{\"environment\":{}}"
         );
         fclose(f);
+        ut_stat_cache_invalidate(bake_json);
     }
 
     JSON_Value *root = json_parse_file_with_comments(bake_json);
@@ -812,6 +825,7 @@ int16_t bake_config_unset(
             "{\"environment\":{}}"
         );
         fclose(f);
+        ut_stat_cache_invalidate(bake_json);
     }
 
     JSON_Value *root = json_parse_file_with_comments(bake_json);
@@ -864,6 +878,7 @@ int16_t bake_config_use_bundle(
             "{\"bundles\":{}}"
         );
         fclose(f);
+        ut_stat_cache_invalidate(bake_json);
     }
 
     if (!bundle) {
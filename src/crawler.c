@@ -318,97 +318,515 @@ error:
     return -1;
 }
 
+/* Number of threads that discover projects when bake isn't invoked with -j */
+#define BAKE_CRAWLER_THREADS (8)
+
+/* The discovery cache stores the directory tree found by the last crawl with
+ * the modification time of each directory, and the contents of each
+ * project.json. Directories that did not change since the last crawl don't
+ * have to be read again, and unchanged project.json files are not parsed. */
+#define BAKE_CRAWLER_CACHE_FILE ".bake_cache"UT_OS_PS"discovery.json"
+#define BAKE_CRAWLER_CACHE_VERSION (1)
+
+/* Directory found while discovering projects */
+typedef struct bake_crawler_dir {
+    char *path;
+    const char *name;
+    bool is_project;
+    bool failed;
+    struct bake_crawler_dir **dirs;
+    uint32_t dir_count;
+    time_t modified;            /* Modification time of directory */
+    time_t json_modified;       /* Modification time of project.json */
+    JSON_Object *cached;        /* Directory in discovery cache */
+    JSON_Value *json;           /* Contents of project.json if unchanged */
+} bake_crawler_dir;
+
+/* Directories are read in parallel. Workers take directories from a queue, and
+ * add the subdirectories they find to it. Subdirectories of projects are not
+ * added, as they can only be read once the project is loaded and it is known
+ * which directories its drivers ignore. */
+typedef struct bake_crawler_scan {
+    bake_crawler_dir **queue;
+    uint32_t queue_count;
+    uint32_t queue_size;
+    uint32_t busy;
+    ut_mutex_s lock;
+    ut_cond_s cond;
+} bake_crawler_scan;
+
+/* Directories that have a special meaning in a project */
+static const char *bake_crawler_project_dirs[] = {
+    "src", "include", "config", "data", "test", "etc", "lib", "bin", "install",
+    "examples", "bake", ".bake_cache", NULL
+};
+
 static
-int16_t bake_crawler_crawl(
+bool bake_crawler_skip_dir(
+    const char *name,
+    bool is_project)
+{
+    if (name[0] == '.') {
+        return true;
+    }
+
+    /* Never try to build bake with bake, in case it is found in the source
+     * tree */
+    if (!strcmp(name, "bake")) {
+        return true;
+    }
+
+    if (is_project) {
+        const char **dir;
+        for (dir = bake_crawler_project_dirs; *dir; dir ++) {
+            if (!strcmp(name, *dir)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static
+int bake_crawler_compare_dir(
+    const void *ptr1,
+    const void *ptr2)
+{
+    const bake_crawler_dir *dir1 = *(bake_crawler_dir**)ptr1;
+    const bake_crawler_dir *dir2 = *(bake_crawler_dir**)ptr2;
+    return strcmp(dir1->name, dir2->name);
+}
+
+static
+bake_crawler_dir* bake_crawler_add_subdir(
+    bake_crawler_dir *dir,
+    const char *name)
+{
+    bake_crawler_dir *sub = ut_calloc(sizeof(bake_crawler_dir));
+    sub->path = ut_asprintf("%s"UT_OS_PS"%s", dir->path, name);
+    sub->name = &sub->path[strlen(dir->path) + 1];
+
+    dir->dirs = realloc(dir->dirs,
+        (dir->dir_count + 1) * sizeof(bake_crawler_dir*));
+    dir->dirs[dir->dir_count ++] = sub;
+
+    return sub;
+}
+
+/* Get project.json from the discovery cache if it did not change */
+static
+void bake_crawler_read_cached_json(
+    bake_crawler_dir *dir)
+{
+    char *file = ut_asprintf("%s"UT_OS_PS"project.json", dir->path);
+    dir->json_modified = ut_lastmodified(file);
+    if (dir->json_modified == -1) {
+        ut_catch();
+    } else if (dir->cached) {
+        JSON_Object *project = json_object_get_object(dir->cached, "project");
+        if (project && dir->json_modified ==
+            (time_t)json_object_get_number(project, "modified"))
+        {
+            dir->json = json_object_get_value(project, "json");
+        }
+    }
+    free(file);
+}
+
+/* Get subdirectories from the discovery cache if the directory did not
+ * change. Returns false if the directory has to be read. */
+static
+bool bake_crawler_read_cached_dir(
+    bake_crawler_dir *dir)
+{
+    if (!dir->cached || !dir->modified || dir->modified !=
+        (time_t)json_object_get_number(dir->cached, "modified"))
+    {
+        return false;
+    }
+
+    dir->is_project = json_object_has_value(dir->cached, "project");
+
+    JSON_Object *dirs = json_object_get_object(dir->cached, "dirs");
+    uint32_t i, count = json_object_get_count(dirs);
+    for (i = 0; i < count; i ++) {
+        bake_crawler_dir *sub = bake_crawler_add_subdir(
+            dir, json_object_get_name(dirs, i));
+        sub->cached = json_value_get_object(
+            json_object_get_value_at(dirs, i));
+    }
+
+    return true;
+}
+
+/* Find project.json and subdirectories of directory. Subdirectories are sorted
+ * by name, so that projects are discovered in the same order every time. */
+static
+void bake_crawler_read_dir(
+    bake_crawler_dir *dir)
+{
+    ut_dir_entry *entries;
+    uint32_t i, count;
+
+    dir->modified = ut_lastmodified(dir->path);
+    if (dir->modified == -1) {
+        ut_catch();
+        dir->failed = true;
+        return;
+    }
+
+    if (bake_crawler_read_cached_dir(dir)) {
+        goto done;
+    }
+
+    if (ut_dir_entries(dir->path, &entries, &count)) {
+        ut_catch();
+        dir->failed = true;
+        return;
+    }
+
+    JSON_Object *cached_dirs = NULL;
+    if (dir->cached) {
+        cached_dirs = json_object_get_object(dir->cached, "dirs");
+    }
+
+    for (i = 0; i < count; i ++) {
+        if (!entries[i].is_dir && !strcmp(entries[i].name, "project.json")) {
+            dir->is_project = true;
+        }
+    }
+
+    for (i = 0; i < count; i ++) {
+        if (!entries[i].is_dir) {
+            continue;
+        }
+
+        if (bake_crawler_skip_dir(entries[i].name, dir->is_project)) {
+            continue;
+        }
+
+        bake_crawler_dir *sub = bake_crawler_add_subdir(dir, entries[i].name);
+        if (cached_dirs) {
+            sub->cached = json_object_get_object(cached_dirs, sub->name);
+        }
+    }
+
+    if (dir->dir_count) {
+        qsort(dir->dirs, dir->dir_count, sizeof(bake_crawler_dir*),
+            bake_crawler_compare_dir);
+    }
+
+    ut_dir_entries_free(entries, count);
+
+done:
+    if (dir->is_project) {
+        bake_crawler_read_cached_json(dir);
+    }
+}
+
+static
+void* bake_crawler_scan_worker(
+    bake_crawler_scan *scan)
+{
+    ut_mutex_lock(&scan->lock);
+
+    while (true) {
+        while (!scan->queue_count && scan->busy) {
+            ut_cond_wait(&scan->cond, &scan->lock);
+        }
+
+        if (!scan->queue_count) {
+            break;
+        }
+
+        bake_crawler_dir *dir = scan->queue[-- scan->queue_count];
+        scan->busy ++;
+        ut_mutex_unlock(&scan->lock);
+
+        bake_crawler_read_dir(dir);
+
+        ut_mutex_lock(&scan->lock);
+
+        if (scan->queue_count + dir->dir_count > scan->queue_size) {
+            scan->queue_size = (scan->queue_count + dir->dir_count) * 2;
+            scan->queue = realloc(scan->queue,
+                scan->queue_size * sizeof(bake_crawler_dir*));
+        }
+
+        uint32_t i;
+        for (i = 0; !dir->is_project && i < dir->dir_count; i ++) {
+            scan->queue[scan->queue_count ++] = dir->dirs[i];
+        }
+
+        scan->busy --;
+        ut_cond_broadcast(&scan->cond);
+    }
+
+    ut_mutex_unlock(&scan->lock);
+
+    return NULL;
+}
+
+/* Read directory trees on a bounded number of threads */
+static
+void bake_crawler_scan_tree(
     bake_config *config,
-    const char *wd,
-    const char *path)
+    bake_crawler_dir **roots,
+    uint32_t count)
 {
-    char *prev = strdup(ut_cwd());
-    char *fullpath;
-    if (ut_path_is_relative(path)) {
-        fullpath = ut_asprintf("%s"UT_OS_PS"%s", wd, path);
-        ut_path_clean(fullpath, fullpath);
-    } else {
-        fullpath = ut_strdup(path);
+    uint32_t i, worker_count =
+        config->jobs > 1 ? config->jobs : BAKE_CRAWLER_THREADS;
+
+    bake_crawler_scan scan = {
+        .queue = malloc(count * sizeof(bake_crawler_dir*)),
+        .queue_count = count,
+        .queue_size = count
+    };
+
+    memcpy(scan.queue, roots, count * sizeof(bake_crawler_dir*));
+
+    ut_mutex_new(&scan.lock);
+    ut_cond_new(&scan.cond);
+
+    ut_thread *workers = ut_calloc(sizeof(ut_thread) * worker_count);
+    for (i = 0; i < worker_count; i ++) {
+        workers[i] = ut_thread_new(
+            (ut_thread_cb)bake_crawler_scan_worker, &scan);
     }
 
-    bool isProject = false;
+    for (i = 0; i < worker_count; i ++) {
+        ut_thread_join(workers[i], NULL);
+    }
+
+    ut_cond_free(&scan.cond);
+    ut_mutex_free(&scan.lock);
+    free(scan.queue);
+    free(workers);
+}
+
+static
+void bake_crawler_dir_free(
+    bake_crawler_dir *dir)
+{
+    uint32_t i;
+    for (i = 0; i < dir->dir_count; i ++) {
+        bake_crawler_dir_free(dir->dirs[i]);
+    }
+    free(dir->dirs);
+    free(dir->path);
+    free(dir);
+}
+
+/* Load projects in directory tree, in depth-first order */
+static
+int16_t bake_crawler_add_dir(
+    bake_config *config,
+    bake_crawler_dir *dir)
+{
     bake_project *p = NULL;
+    uint32_t i;
 
-    if (ut_file_test(strarg("%s"UT_OS_PS"project.json", fullpath))) {
-        isProject = true;
+    if (dir->failed) {
+        ut_throw("failed to open directory '%s'", dir->path);
+        goto error;
+    }
+
+    if (dir->is_project) {
+        if (dir->json) {
+            p = bake_project_new_w_json(
+                dir->path, config, json_value_deep_copy(dir->json));
+        } else {
+            p = bake_project_new(dir->path, config);
+        }
 
-        p = bake_project_new(fullpath, config);
         if (!p) {
-            ut_warning("ignoring '%s' because of errors", fullpath);
+            ut_warning("ignoring '%s' because of errors", dir->path);
+            dir->json = NULL;
         } else {
+            /* Borrowed from project until the cache is saved */
+            dir->json = json_object_get_wrapping_value(p->json);
+
             if (bake_crawler_add(config, p)) {
-                ut_warning("ignoring '%s' because of errors", fullpath);
+                ut_warning("ignoring '%s' because of errors", dir->path);
             }
         }
-    }
 
-    ut_iter it;
-    if (ut_dir_iter(fullpath, NULL, &it)) {
-        ut_throw("failed to open directory '%s'", fullpath);
-        goto error;
+        /* Read subdirectories of project that are not ignored */
+        bake_crawler_dir **subs = malloc(
+            (dir->dir_count + 1) * sizeof(bake_crawler_dir*));
+        uint32_t count = 0;
+        for (i = 0; i < dir->dir_count; i ++) {
+            if (!p || !bake_project_should_ignore(p, dir->dirs[i]->name)) {
+                subs[count ++] = dir->dirs[i];
+            }
+        }
+
+        if (count) {
+            bake_crawler_scan_tree(config, subs, count);
+        }
+
+        free(subs);
     }
 
-    while (ut_iter_hasNext(&it)) {
-        char *file = ut_iter_next(&it);
+    for (i = 0; i < dir->dir_count; i ++) {
+        bake_crawler_dir *sub = dir->dirs[i];
 
-        if (file[0] == '.') {
+        if (p && bake_project_should_ignore(p, sub->name)) {
+            ut_debug("ignoring directory '%s'", sub->name);
             continue;
         }
 
-        if (ut_isdir(strarg("%s"UT_OS_PS"%s", fullpath, file))) {
-
-            /* If this is a bake project, filter out directories that have
-             * special meaning. */
-            if (isProject) {
-                if (!strcmp(file, "src") ||
-                    !strcmp(file, "include") ||
-                    !strcmp(file, "config") ||
-                    !strcmp(file, "data") ||
-                    !strcmp(file, "test") ||
-                    !strcmp(file, "etc") ||
-                    !strcmp(file, "lib") ||
-                    !strcmp(file, "bin") ||
-                    !strcmp(file, "install") ||
-                    !strcmp(file, "examples") ||
-                    !strcmp(file, "bake") ||
-                    !strcmp(file, ".bake_cache") ||
-                    (p && bake_project_should_ignore(p, file)))
-                {
-                    ut_debug("ignoring directory '%s'", file);
-                    continue;
-                }
+        ut_debug("looking for projects in '%s'", sub->name);
 
-                ut_debug("looking for projects in '%s'", file);
+        ut_try( bake_crawler_add_dir(config, sub), NULL);
+    }
 
-                /* TODO: ignore generated directories */
+    return 0;
+error:
+    return -1;
+}
 
-            /* Never try to build bake with bake, in case it is found in the source tree */
-            } else if (!strcmp(file, "bake")) {
-                ut_debug("ignoring directory 'bake'");
-                continue;
-            } else {
-                ut_debug("looking for projects in '%s'", file);
-            }
+static
+JSON_Value* bake_crawler_cache_load(
+    const char *file)
+{
+    if (ut_file_test(file) != 1) {
+        ut_catch();
+        return NULL;
+    }
 
-            if (bake_crawler_crawl(config, fullpath, file)) {
-                ut_iter_release(&it);
-                goto error;
-            }
+    JSON_Value *json = json_parse_file(file);
+    JSON_Object *root = json_value_get_object(json);
+    if (!root || json_object_get_number(root, "version") !=
+        BAKE_CRAWLER_CACHE_VERSION)
+    {
+        /* Not fatal, cache will be recreated */
+        ut_debug("ignoring discovery cache '%s'", file);
+        if (json) {
+            json_value_free(json);
         }
+        return NULL;
     }
 
-skip:
-    return 0;
+    return json;
+}
+
+/* Serialize directory tree. Modification times that are not older than the
+ * start of the crawl are not stored, as the directory or file could change
+ * again within the same second without changing its modification time. */
+static
+JSON_Value* bake_crawler_cache_dir(
+    bake_crawler_dir *dir,
+    time_t start)
+{
+    JSON_Value *json = json_value_init_object();
+    JSON_Object *obj = json_value_get_object(json);
+    uint32_t i;
+
+    json_object_set_number(obj, "modified",
+        dir->modified < start ? dir->modified : 0);
+
+    if (dir->is_project) {
+        JSON_Value *project_json = json_value_init_object();
+        JSON_Object *project = json_value_get_object(project_json);
+
+        if (dir->json && dir->json_modified < start) {
+            json_object_set_number(project, "modified", dir->json_modified);
+            json_object_set_value(
+                project, "json", json_value_deep_copy(dir->json));
+        }
+
+        json_object_set_value(obj, "project", project_json);
+    }
+
+    JSON_Value *dirs_json = json_value_init_object();
+    JSON_Object *dirs = json_value_get_object(dirs_json);
+    for (i = 0; i < dir->dir_count; i ++) {
+        json_object_set_value(dirs, dir->dirs[i]->name,
+            bake_crawler_cache_dir(dir->dirs[i], start));
+    }
+
+    json_object_set_value(obj, "dirs", dirs_json);
+
+    return json;
+}
+
+static
+void bake_crawler_cache_save(
+    bake_crawler_dir *root,
+    const char *file,
+    time_t start)
+{
+    JSON_Value *json = json_value_init_object();
+    JSON_Object *obj = json_value_get_object(json);
+
+    json_object_set_number(obj, "version", BAKE_CRAWLER_CACHE_VERSION);
+    json_object_set_value(obj, "root", bake_crawler_cache_dir(root, start));
+
+    char *cache_path = ut_asprintf("%s"UT_OS_PS".bake_cache", root->path);
+    if (ut_mkdir(cache_path)) {
+        goto error;
+    }
+
+    json_set_escape_slashes(0);
+
+    if (json_serialize_to_file(json, file) != JSONSuccess) {
+        ut_throw("failed to write discovery cache '%s'", file);
+        goto error;
+    }
+
+    json_value_free(json);
+    free(cache_path);
+    return;
 error:
-    if (prev) free(prev);
-    return -1;
+    /* Not fatal, directory could be read-only */
+    ut_catch();
+    json_value_free(json);
+    free(cache_path);
+}
+
+static
+int16_t bake_crawler_crawl(
+    bake_config *config,
+    const char *wd,
+    const char *path)
+{
+    bake_crawler_dir *root = ut_calloc(sizeof(bake_crawler_dir));
+    time_t start = time(NULL);
+
+    if (ut_path_is_relative(path)) {
+        root->path = ut_asprintf("%s"UT_OS_PS"%s", wd, path);
+        ut_path_clean(root->path, root->path);
+    } else {
+        root->path = ut_strdup(path);
+    }
+
+    root->name = root->path;
+
+    char *cache_file = ut_asprintf(
+        "%s"UT_OS_PS BAKE_CRAWLER_CACHE_FILE, root->path);
+    JSON_Value *cache = bake_crawler_cache_load(cache_file);
+    if (cache) {
+        root->cached = json_object_get_object(
+            json_value_get_object(cache), "root");
+    }
+
+    bake_crawler_scan_tree(config, &root, 1);
+
+    int16_t result = bake_crawler_add_dir(config, root);
+    if (!result) {
+        bake_crawler_cache_save(root, cache_file, start);
+    }
+
+    if (cache) {
+        json_value_free(cache);
+    }
+
+    bake_crawler_dir_free(root);
+    free(cache_file);
+
+    return result;
 }
 
 static
@@ -488,6 +906,52 @@ uint32_t bake_crawler_count(void)
     return crawler->count;
 }
 
+ut_ll bake_crawler_paths(void)
+{
+    ut_ll result = ut_ll_new();
+
+    if (crawler->nodes) {
+        ut_iter it = ut_rb_iter(crawler->nodes);
+        while (ut_iter_hasNext(&it)) {
+            bake_project *p = ut_iter_next(&it);
+            if (p->path) {
+                ut_ll_append(result, ut_strdup(p->path));
+            }
+        }
+    }
+
+    if (crawler->leafs) {
+        ut_iter it = ut_ll_iter(crawler->leafs);
+        while (ut_iter_hasNext(&it)) {
+            bake_project *p = ut_iter_next(&it);
+            ut_ll_append(result, ut_strdup(p->path));
+        }
+    }
+
+    return result;
+}
+
+int16_t bake_crawler_add_paths(
+    bake_config *config,
+    ut_ll paths)
+{
+    ut_iter it = ut_ll_iter(paths);
+    while (ut_iter_hasNext(&it)) {
+        char *path = ut_iter_next(&it);
+        bake_project *p = bake_project_new(path, config);
+        if (!p) {
+            ut_throw("failed to load project in '%s'", path);
+            goto error;
+        }
+
+        ut_try (bake_crawler_add(config, p), NULL);
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
 uint32_t bake_crawler_search(
     bake_config *config,
     const char *path,
@@ -571,6 +1035,77 @@ error:
     return -1;
 }
 
+typedef struct bake_crawler_job {
+    bake_config *config;
+    const char *action_name;
+    bake_crawler_cb action;
+    bake_project *project;
+    bake_jobs *jobs;
+    uint32_t *built;
+} bake_crawler_job;
+
+static
+int16_t bake_crawler_build_job(
+    void *ctx);
+
+static
+void bake_crawler_add_job(
+    bake_crawler_job *parent,
+    bake_project *p)
+{
+    bake_crawler_job *job = ut_calloc(sizeof(bake_crawler_job));
+    *job = *parent;
+    job->project = p;
+    bake_jobs_add(job->jobs, bake_crawler_build_job, job);
+}
+
+static
+int16_t bake_crawler_build_job(
+    void *ctx)
+{
+    bake_crawler_job *job = ctx;
+    bake_project *p = job->project;
+    ut_ll readyForBuild = ut_ll_new();
+    ut_strbuf log = UT_STRBUF_INIT, *prev_log = NULL;
+    bool capture = job->config->jobs > 1;
+    int16_t result = 0;
+
+    /* When building projects in parallel, print the output of a project in
+     * one piece, so it doesn't get mixed up with output of other projects. */
+    if (capture) {
+        prev_log = ut_log_capture(&log);
+    }
+
+    if (bake_crawler_build_project(
+            job->config, job->action_name, job->action, p, readyForBuild))
+    {
+        ut_error("project #[red]%s#[reset] built with errors", p->id);
+        result = -1;
+    }
+
+    (*job->built) ++;
+
+    if (capture) {
+        ut_log_capture(prev_log);
+        char *str = ut_strbuf_get(&log);
+        if (str) {
+            fputs(str, stdout);
+            fflush(stdout);
+            free(str);
+        }
+    }
+
+    /* Schedule dependents of which all dependencies have been built */
+    while ((p = ut_ll_takeFirst(readyForBuild))) {
+        bake_crawler_add_job(job, p);
+    }
+
+    ut_ll_free(readyForBuild);
+    free(job);
+
+    return result;
+}
+
 static
 void bake_crawler_collect_ready_for_build(
     ut_iter *it,
@@ -619,18 +1154,28 @@ int16_t bake_crawler_walk(
         bake_crawler_collect_ready_for_build(&it, readyForBuild);
     }
 
-    /* Walk projects (when dependencies are resolved the list will populate) */
+    /* Walk projects (when dependencies are resolved, jobs are added for
+     * dependents). Projects that don't depend on each other may be built in
+     * parallel when more than one job is configured. */
+    bake_jobs_start(config->jobs);
+
+    bake_crawler_job job = {
+        .config = config,
+        .action_name = action_name,
+        .action = action,
+        .jobs = bake_jobs_new(),
+        .built = &built
+    };
+
     bake_project *p;
     while ((p = ut_ll_takeFirst(readyForBuild))) {
-        if (bake_crawler_build_project(
-                config, action_name, action, p, readyForBuild))
-        {
-            ut_error("project #[red]%s#[reset] built with errors", p->id);
-            result = -1;
-        }
-        built ++;
+        bake_crawler_add_job(&job, p);
     }
 
+    result = bake_jobs_wait(job.jobs);
+
+    bake_jobs_stop();
+
     /* If there are still unbuilt projects it could be a dependency cycle or a
      * dependency for another project that failed to build. */
     if (built != crawler->count) {
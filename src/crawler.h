@@ -55,6 +55,23 @@ uint32_t bake_crawler_search(
  */
 uint32_t bake_crawler_count(void);
 
+/** Get paths of projects found by searches.
+ *
+ * @return List with paths, to be freed by the application.
+ */
+ut_ll bake_crawler_paths(void);
+
+/** Add projects in paths returned by bake_crawler_paths.
+ * This adds the same projects as the searches that returned the paths, without
+ * searching directories.
+ *
+ * @param paths List with project paths.
+ * @return 0 if success, non-zero if failed.
+ */
+int16_t bake_crawler_add_paths(
+    bake_config *config,
+    ut_ll paths);
+
 /** Manually add a project to the crawler.
  *
  * @param _this A crawler object.
@@ -0,0 +1,570 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* The build daemon is a long running bake process that builds projects on
+ * request of bake clients. It keeps the configuration, loaded drivers, the
+ * list of discovered projects and their parsed project.json files (in the
+ * metadata cache) in memory, so that a build doesn't have to pay for startup.
+ * Clients connect to a UNIX socket in the .bake_cache directory of the path the
+ * daemon was started in. The daemon watches the directory tree with inotify,
+ * and rediscovers projects when directories or project files are added or
+ * removed.
+ *
+ * The client sends a single line with the action and the configuration
+ * signature. The daemon sends back the build output, followed by a '\0' and the
+ * return code of the build, or by "\0R" if it rejects the request. A request is
+ * rejected when the client uses a different configuration than the daemon, in
+ * which case the client builds the projects itself. */
+
+#include "bake.h"
+
+#ifdef UT_OS_LINUX
+
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define BAKE_DAEMON_SOCKET ".bake_cache"UT_OS_PS"daemon.sock"
+#define BAKE_DAEMON_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM |\
+    IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+static volatile sig_atomic_t bake_daemon_quit;
+
+static
+void bake_daemon_signal(
+    int sig)
+{
+    bake_daemon_quit = 1;
+}
+
+static
+char* bake_daemon_socket_file(
+    const char *path)
+{
+    char *result;
+    if (ut_path_is_relative(path)) {
+        result = ut_asprintf(
+            "%s"UT_OS_PS"%s"UT_OS_PS BAKE_DAEMON_SOCKET, ut_cwd(), path);
+    } else {
+        result = ut_asprintf("%s"UT_OS_PS BAKE_DAEMON_SOCKET, path);
+    }
+
+    ut_path_clean(result, result);
+
+    return result;
+}
+
+static
+int bake_daemon_socket_addr(
+    const char *file,
+    struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+
+    if (strlen(file) >= sizeof(addr->sun_path)) {
+        ut_throw("socket path '%s' is too long", file);
+        return -1;
+    }
+
+    strcpy(addr->sun_path, file);
+
+    return 0;
+}
+
+/* Test if socket file exists. Sockets can't be opened like regular files, so
+ * this doesn't use ut_file_test. */
+static
+bool bake_daemon_socket_exists(
+    const char *file)
+{
+    struct stat st;
+    return !stat(file, &st) && S_ISSOCK(st.st_mode);
+}
+
+/* Connect to socket, returns -1 if no daemon is listening */
+static
+int bake_daemon_connect(
+    const char *file)
+{
+    struct sockaddr_un addr;
+    if (bake_daemon_socket_addr(file, &addr)) {
+        ut_catch();
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static
+int16_t bake_daemon_write(
+    int fd,
+    const char *buf,
+    size_t len)
+{
+    while (len) {
+        ssize_t written = write(fd, buf, len);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+/* Add watches for directory and its subdirectories. Only directories matter
+ * for discovery, as projects are only discovered in directories. */
+static
+int16_t bake_daemon_watch_dir(
+    int fd,
+    const char *dir)
+{
+    if (inotify_add_watch(fd, dir, BAKE_DAEMON_EVENTS) == -1) {
+        ut_throw("failed to watch '%s': %s", dir, strerror(errno));
+        goto error;
+    }
+
+    ut_iter it;
+    ut_try (ut_dir_iter(dir, NULL, &it), NULL);
+
+    while (ut_iter_hasNext(&it)) {
+        char *file = ut_iter_next(&it);
+
+        /* Discovery skips hidden directories */
+        if (file[0] == '.' || !strcmp(file, "bin")) {
+            continue;
+        }
+
+        char *file_path = ut_asprintf("%s"UT_OS_PS"%s", dir, file);
+        if (ut_isdir(file_path)) {
+            if (bake_daemon_watch_dir(fd, file_path)) {
+                free(file_path);
+                ut_iter_release(&it);
+                goto error;
+            }
+        }
+        free(file_path);
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+/* Test if inotify events invalidate the discovered projects */
+static
+bool bake_daemon_read_events(
+    int fd)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    bool invalidated = false;
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        char *ptr = buf;
+        while (ptr < buf + len) {
+            struct inotify_event *event = (struct inotify_event*)ptr;
+
+            if (event->mask & (IN_ISDIR | IN_Q_OVERFLOW | IN_DELETE_SELF |
+                IN_MOVE_SELF))
+            {
+                invalidated = true;
+            } else if (event->len && !strcmp(event->name, "project.json")) {
+                invalidated = true;
+            }
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return invalidated;
+}
+
+/* (Re)create watches for directory tree. Returns inotify descriptor, or -1 if
+ * the tree can't be watched, in which case every request rediscovers. */
+static
+int bake_daemon_watch(
+    const char *path)
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        ut_warning("failed to initialize inotify: %s", strerror(errno));
+        return -1;
+    }
+
+    if (bake_daemon_watch_dir(fd, path)) {
+        ut_raise();
+        ut_warning("cannot watch '%s', projects are rediscovered for every build",
+            path);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Read request line from client */
+static
+char* bake_daemon_read_request(
+    int fd)
+{
+    ut_strbuf buf = UT_STRBUF_INIT;
+    size_t total = 0;
+    char ch;
+
+    while (total < 4096) {
+        ssize_t ret = read(fd, &ch, 1);
+        if (ret == -1 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0 || ch == '\n') {
+            break;
+        }
+        ut_strbuf_appendstrn(&buf, &ch, 1);
+        total ++;
+    }
+
+    char *result = ut_strbuf_get(&buf);
+    if (!result) {
+        result = ut_strdup("");
+    }
+
+    return result;
+}
+
+static
+void bake_daemon_serve(
+    bake_config *config,
+    int client,
+    const char *signature,
+    bool *invalidated,
+    int *watch_fd,
+    const char *path,
+    bake_daemon_build_cb build)
+{
+    char *request = bake_daemon_read_request(client);
+    char *request_sig = strchr(request, ' ');
+    const char *action = request;
+    char trailer[16];
+
+    if (request_sig) {
+        request_sig[0] = '\0';
+        request_sig ++;
+    }
+
+    if (!request_sig || strcmp(request_sig, signature) || (
+        strcmp(action, "build") && strcmp(action, "rebuild") &&
+        strcmp(action, "clean")))
+    {
+        ut_trace("rejected request '%s'", action);
+        bake_daemon_write(client, "\0R", 2);
+        free(request);
+        return;
+    }
+
+    bool rediscover = *invalidated;
+    if (rediscover) {
+        /* Watch tree before discovery, so changes during build aren't lost */
+        if (*watch_fd != -1) {
+            close(*watch_fd);
+        }
+        *watch_fd = bake_daemon_watch(path);
+        *invalidated = *watch_fd == -1;
+    }
+
+    /* Redirect output of build (and of processes started by the build) to
+     * the client */
+    fflush(stdout);
+    fflush(stderr);
+    int out = dup(STDOUT_FILENO), err = dup(STDERR_FILENO);
+    dup2(client, STDOUT_FILENO);
+    dup2(client, STDERR_FILENO);
+
+    /* Files may have changed since the last request */
+    ut_stat_cache_invalidate(NULL);
+
+    int16_t ret = build(config, action, rediscover);
+    if (ret) {
+        ut_raise();
+        ut_error("build failed");
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    dup2(out, STDOUT_FILENO);
+    dup2(err, STDERR_FILENO);
+    close(out);
+    close(err);
+
+    if (ret) {
+        /* Projects may have been partially discovered */
+        *invalidated = true;
+    }
+
+    bake_message(UT_LOG, "daemon", "%s %s", action, ret ? "failed" : "done");
+
+    trailer[0] = '\0';
+    int len = snprintf(&trailer[1], sizeof(trailer) - 1, "%d", ret ? 1 : 0);
+    bake_daemon_write(client, trailer, len + 1);
+
+    free(request);
+}
+
+int16_t bake_daemon_run(
+    bake_config *config,
+    const char *path,
+    const char *signature,
+    bake_daemon_build_cb build)
+{
+    char *socket_file = bake_daemon_socket_file(path);
+    struct sockaddr_un addr;
+    int sock = -1, watch_fd = -1;
+    bool invalidated = true;
+
+    ut_try (bake_daemon_socket_addr(socket_file, &addr), NULL);
+
+    if (bake_daemon_socket_exists(socket_file)) {
+        int fd = bake_daemon_connect(socket_file);
+        if (fd != -1) {
+            close(fd);
+            ut_throw("a daemon is already running for '%s'", path);
+            goto error;
+        }
+
+        /* Socket of daemon that didn't exit cleanly */
+        ut_try (ut_rm(socket_file), NULL);
+    }
+
+    char *socket_dir = ut_path_dirname(socket_file);
+    int16_t ret = ut_mkdir(socket_dir);
+    free(socket_dir);
+    ut_try (ret, NULL);
+
+    sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock == -1) {
+        ut_throw("failed to create socket: %s", strerror(errno));
+        goto error;
+    }
+
+    /* Only the user that started the daemon may connect to it */
+    mode_t old_mask = umask(0177);
+    int bind_ret = bind(sock, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+
+    if (bind_ret || listen(sock, 8)) {
+        ut_throw("failed to listen on '%s': %s", socket_file, strerror(errno));
+        goto error;
+    }
+
+    /* Builds started by the daemon (like tests that build projects) should not
+     * send requests to the daemon, as it serves one request at a time. */
+    ut_setenv("BAKE_DAEMON", "TRUE");
+
+    struct sigaction sa = { .sa_handler = bake_daemon_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Output is not written to a terminal, but should not be delayed */
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    bake_message(UT_LOG, "daemon", "listening on #[cyan]%s#[reset]", socket_file);
+
+    while (!bake_daemon_quit) {
+        struct pollfd fds[2] = {
+            { .fd = sock, .events = POLLIN },
+            { .fd = watch_fd, .events = POLLIN }
+        };
+
+        int count = poll(fds, watch_fd != -1 ? 2 : 1, -1);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ut_throw("poll failed: %s", strerror(errno));
+            goto error;
+        }
+
+        if (watch_fd != -1 && (fds[1].revents & POLLIN)) {
+            if (bake_daemon_read_events(watch_fd) && !invalidated) {
+                ut_trace("directory tree changed, rediscovering projects");
+                invalidated = true;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client = accept(sock, NULL, NULL);
+            if (client == -1) {
+                continue;
+            }
+
+            fcntl(client, F_SETFD, FD_CLOEXEC);
+
+            /* Pick up changes that happened since the last poll */
+            if (watch_fd != -1 && bake_daemon_read_events(watch_fd)) {
+                invalidated = true;
+            }
+
+            bake_daemon_serve(config, client, signature, &invalidated,
+                &watch_fd, path, build);
+
+            close(client);
+        }
+    }
+
+    bake_message(UT_LOG, "daemon", "stopped");
+
+    close(sock);
+    if (watch_fd != -1) {
+        close(watch_fd);
+    }
+    ut_rm(socket_file);
+    free(socket_file);
+
+    return 0;
+error:
+    if (sock != -1) {
+        close(sock);
+        ut_rm(socket_file);
+    }
+    if (watch_fd != -1) {
+        close(watch_fd);
+    }
+    free(socket_file);
+    return -1;
+}
+
+int bake_daemon_request(
+    const char *path,
+    const char *action,
+    const char *signature)
+{
+    char *socket_file = bake_daemon_socket_file(path);
+    int result = -1;
+    int fd = -1;
+
+    if (!bake_daemon_socket_exists(socket_file)) {
+        goto done;
+    }
+
+    if ((fd = bake_daemon_connect(socket_file)) == -1) {
+        ut_trace("no daemon listening on '%s'", socket_file);
+        goto done;
+    }
+
+    char *request = ut_asprintf("%s %s\n", action, signature);
+    int16_t ret = bake_daemon_write(fd, request, strlen(request));
+    free(request);
+    if (ret) {
+        goto done;
+    }
+
+    /* Print output until the trailer, which starts with a '\0' */
+    ut_strbuf trailer = UT_STRBUF_INIT;
+    bool in_trailer = false;
+    char buf[4096];
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof(buf))) != 0) {
+        if (len == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        ssize_t out_len = len;
+        if (!in_trailer) {
+            char *end = memchr(buf, '\0', len);
+            if (end) {
+                out_len = end - buf;
+                in_trailer = true;
+                ut_strbuf_appendstrn(&trailer, end + 1, len - out_len - 1);
+            }
+            fwrite(buf, 1, out_len, stdout);
+            fflush(stdout);
+        } else {
+            ut_strbuf_appendstrn(&trailer, buf, len);
+        }
+    }
+
+    char *trailer_str = ut_strbuf_get(&trailer);
+    if (!in_trailer) {
+        ut_error("connection to daemon was lost");
+        result = 1;
+    } else if (trailer_str && trailer_str[0] == 'R') {
+        ut_trace("daemon rejected request (configuration does not match)");
+    } else if (trailer_str) {
+        result = atoi(trailer_str);
+    } else {
+        result = 0;
+    }
+
+    free(trailer_str);
+done:
+    if (fd != -1) {
+        close(fd);
+    }
+    free(socket_file);
+    return result;
+}
+
+#else
+
+int16_t bake_daemon_run(
+    bake_config *config,
+    const char *path,
+    const char *signature,
+    bake_daemon_build_cb build)
+{
+    ut_throw("daemon is not supported on this platform");
+    return -1;
+}
+
+int bake_daemon_request(
+    const char *path,
+    const char *action,
+    const char *signature)
+{
+    return -1;
+}
+
+#endif
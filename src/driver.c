@@ -501,6 +501,21 @@ void bake_driver_set_attr_bool_cb(
     bake_project_set_attr_bool(config, project, driver->id, name, value);
 }
 
+static
+void bake_driver_command_cb(
+    const char *name,
+    bake_rule_command_cb command)
+{
+    bake_driver *driver = ut_tls_get(BAKE_DRIVER_KEY);
+    bake_node *n = bake_node_find(driver, name);
+    if (!n || n->kind != BAKE_RULE_RULE) {
+        ut_throw("rule '%s' not found for command", name);
+        driver->error = true;
+    } else {
+        ((bake_rule*)n)->command = command;
+    }
+}
+
 static
 void bake_driver_exec_cb(
     const char *cmd)
@@ -511,8 +526,36 @@ void bake_driver_exec_cb(
         bake_project *p = ut_tls_get(BAKE_PROJECT_KEY);
         p->error = true;
     } else {
+        bake_config *config = ut_tls_get(BAKE_CONFIG_KEY);
+        FILE *out = NULL;
         int8_t ret = 0;
-        int sig = ut_proc_cmd(envcmd, &ret);
+        int sig = -1;
+
+        /* When projects are built in parallel, collect the command output so
+         * it is printed in one piece with the rest of the project output */
+        if (config && config->jobs > 1) {
+            out = tmpfile();
+        }
+
+        ut_proc pid;
+        if (out) {
+            pid = ut_proc_cmd_runRedirect(envcmd, out, out);
+        } else {
+            pid = ut_proc_cmd_run(envcmd);
+        }
+
+        if (pid) {
+            bool suspended = bake_jobs_suspend();
+            sig = ut_proc_wait(pid, &ret);
+            if (suspended) {
+                bake_jobs_resume();
+            }
+        }
+
+        if (out) {
+            bake_jobs_output(out);
+        }
+
         if (sig || ret) {
             if (!sig) {
                 ut_throw("command returned %d", ret);
@@ -658,6 +701,7 @@ bake_driver_api bake_driver_api_impl = {
     .rule = bake_driver_rule_cb,
     .dependency_rule = bake_driver_dependency_rule_cb,
     .condition = bake_driver_condition_cb,
+    .command = bake_driver_command_cb,
     .target_pattern = bake_driver_target_pattern_cb,
     .target_file = bake_driver_target_file_cb,
     .target_map = bake_driver_target_map_cb,
@@ -674,6 +718,8 @@ bake_driver_api bake_driver_api_impl = {
     .clean = bake_driver_clean_cb,
     .remove = bake_driver_remove_cb,
     .exec = bake_driver_exec_cb,
+    .target_outdated = bake_node_target_outdated,
+    .target_built = bake_node_target_built,
     .use = bake_driver_use_cb,
     .exists = bake_driver_exists_cb,
     .lookup = bake_driver_lookup_cb,
@@ -734,6 +780,9 @@ char* bake_driver__link_to_lib(
     return NULL;
 }
 
+/* Drivers write files with their own copy of bake-util, which doesn't update
+ * the stat cache of bake, so the cache is suspended while driver code runs. */
+
 int16_t bake_driver__clean(
     bake_driver *driver,
     bake_config *config,
@@ -745,8 +794,10 @@ int16_t bake_driver__clean(
         bake_project *old_project = ut_tls_get(BAKE_PROJECT_KEY);
         ut_tls_set(BAKE_PROJECT_KEY, project);
 
+        ut_stat_cache_suspend();
         driver->impl.clean(
             &bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -770,7 +821,9 @@ int16_t bake_driver__setup(
         bake_project *old_project = ut_tls_get(BAKE_PROJECT_KEY);
         ut_tls_set(BAKE_PROJECT_KEY, project);
 
+        ut_stat_cache_suspend();
         driver->impl.setup(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -801,7 +854,9 @@ int16_t bake_driver__init(
 
         ut_trace("%s: init", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.init(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -827,7 +882,9 @@ int16_t bake_driver__generate(
 
         ut_trace("%s: generate", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.generate(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -853,7 +910,9 @@ int16_t bake_driver__prebuild(
 
         ut_trace("%s: prebuild", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.prebuild(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -879,7 +938,9 @@ int16_t bake_driver__build(
 
         ut_trace("%s: build", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.build(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -905,7 +966,9 @@ int16_t bake_driver__postbuild(
 
         ut_trace("%s: postbuild", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.postbuild(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -931,7 +994,9 @@ int16_t bake_driver__test(
 
         ut_trace("%s: test", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.test(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
@@ -958,7 +1023,9 @@ int16_t bake_driver__coverage(
 
         ut_trace("%s: coverage", driver->id);
 
+        ut_stat_cache_suspend();
         driver->impl.coverage(&bake_driver_api_impl, config, project);
+        ut_stat_cache_resume();
 
         ut_tls_set(BAKE_DRIVER_KEY, old_driver);
         ut_tls_set(BAKE_PROJECT_KEY, old_project);
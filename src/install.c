@@ -289,6 +289,8 @@ int16_t bake_install_metadata(
 
             fprintf(src_location, "%s\n", project->fullpath);
             fclose(src_location);
+            ut_stat_cache_invalidate(
+                strarg("%s"UT_OS_PS"source.txt", projectDir));
 
             /* If project contains dependee JSON, write to dependee.json */
             if (project->dependee_json && strlen(project->dependee_json)) {
@@ -302,8 +304,15 @@ int16_t bake_install_metadata(
                 }
                 fprintf(dependee_config, "%s\n", project->dependee_json);
                 fclose(dependee_config);
+                ut_stat_cache_invalidate(
+                    strarg("%s"UT_OS_PS"dependee.json", projectDir));
                 ut_trace("#[cyan]write %s"UT_OS_PS"dependee.json", projectDir);
             }
+
+            /* Files of project were rewritten, make sure they're loaded again
+             * even if the modification time didn't change */
+            bake_metadata_invalidate(projectDir);
+
             free(projectDir);
         }
     }
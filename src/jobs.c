@@ -0,0 +1,266 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "bake.h"
+
+extern ut_tls BAKE_DRIVER_KEY;
+extern ut_tls BAKE_PROJECT_KEY;
+extern ut_tls BAKE_CONFIG_KEY;
+
+typedef struct bake_job {
+    bake_jobs *jobs;
+    bake_job_cb action;
+    void *ctx;
+} bake_job;
+
+struct bake_jobs {
+    uint32_t pending;      /* Number of jobs that haven't finished yet */
+    int16_t result;
+
+    /* Context inherited by jobs */
+    bake_driver *driver;
+    bake_project *project;
+    bake_config *config;
+    ut_strbuf *log;
+};
+
+/* Only one job at a time holds the lock. The lock is released while a job
+ * waits for a process, or while a thread waits for new jobs. */
+static ut_mutex_s bake_jobs_lock = UT_MUTEX_INIT;
+static ut_cond_s bake_jobs_cond = UT_COND_INIT;
+static ut_ll bake_jobs_queue;
+static ut_thread *bake_jobs_workers;
+static uint32_t bake_jobs_worker_count;
+static bool bake_jobs_quit;
+static char *bake_jobs_cwd;
+
+static
+void bake_jobs_run(
+    bake_job *job)
+{
+    bake_jobs *jobs = job->jobs;
+
+    bake_driver *old_driver = ut_tls_get(BAKE_DRIVER_KEY);
+    bake_project *old_project = ut_tls_get(BAKE_PROJECT_KEY);
+    bake_config *old_config = ut_tls_get(BAKE_CONFIG_KEY);
+    ut_tls_set(BAKE_DRIVER_KEY, jobs->driver);
+    ut_tls_set(BAKE_PROJECT_KEY, jobs->project);
+    ut_tls_set(BAKE_CONFIG_KEY, jobs->config);
+    ut_strbuf *old_log = ut_log_capture(jobs->log);
+
+    if (job->action(job->ctx)) {
+        jobs->result = -1;
+    }
+
+    ut_log_capture(old_log);
+    ut_tls_set(BAKE_DRIVER_KEY, old_driver);
+    ut_tls_set(BAKE_PROJECT_KEY, old_project);
+    ut_tls_set(BAKE_CONFIG_KEY, old_config);
+
+    jobs->pending --;
+    free(job);
+
+    if (bake_jobs_worker_count) {
+        ut_cond_broadcast(&bake_jobs_cond);
+    }
+}
+
+static
+bake_job* bake_jobs_take(
+    bake_jobs *jobs)
+{
+    ut_iter it = ut_ll_iter(bake_jobs_queue);
+    while (ut_iter_hasNext(&it)) {
+        bake_job *job = ut_iter_next(&it);
+        if (!jobs || job->jobs == jobs) {
+            ut_ll_remove(bake_jobs_queue, job);
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static
+void* bake_jobs_worker(
+    void *arg)
+{
+    (void)arg;
+
+    ut_mutex_lock(&bake_jobs_lock);
+
+    while (!bake_jobs_quit) {
+        bake_job *job = bake_jobs_take(NULL);
+        if (job) {
+            bake_jobs_run(job);
+        } else {
+            ut_cond_wait(&bake_jobs_cond, &bake_jobs_lock);
+        }
+    }
+
+    ut_mutex_unlock(&bake_jobs_lock);
+
+    return NULL;
+}
+
+void bake_jobs_start(
+    uint32_t count)
+{
+    if (!bake_jobs_queue) {
+        bake_jobs_queue = ut_ll_new();
+    }
+
+    bake_jobs_quit = false;
+
+    /* The calling thread runs jobs while it waits, so it counts as a worker */
+    if (count > 1) {
+        uint32_t i;
+
+        bake_jobs_cwd = ut_strdup(ut_cwd());
+        bake_jobs_worker_count = count - 1;
+        bake_jobs_workers = malloc(sizeof(ut_thread) * bake_jobs_worker_count);
+
+        ut_mutex_lock(&bake_jobs_lock);
+
+        for (i = 0; i < bake_jobs_worker_count; i ++) {
+            bake_jobs_workers[i] = ut_thread_new(bake_jobs_worker, NULL);
+        }
+    }
+}
+
+void bake_jobs_stop(void)
+{
+    if (bake_jobs_worker_count) {
+        uint32_t i;
+
+        bake_jobs_quit = true;
+        ut_cond_broadcast(&bake_jobs_cond);
+        ut_mutex_unlock(&bake_jobs_lock);
+
+        for (i = 0; i < bake_jobs_worker_count; i ++) {
+            ut_thread_join(bake_jobs_workers[i], NULL);
+        }
+
+        free(bake_jobs_workers);
+        free(bake_jobs_cwd);
+        bake_jobs_workers = NULL;
+        bake_jobs_worker_count = 0;
+    }
+
+    ut_ll_free(bake_jobs_queue);
+    bake_jobs_queue = NULL;
+}
+
+bake_jobs* bake_jobs_new(void)
+{
+    bake_jobs *result = ut_calloc(sizeof(bake_jobs));
+    result->driver = ut_tls_get(BAKE_DRIVER_KEY);
+    result->project = ut_tls_get(BAKE_PROJECT_KEY);
+    result->config = ut_tls_get(BAKE_CONFIG_KEY);
+    result->log = ut_log_captured();
+    return result;
+}
+
+void bake_jobs_add(
+    bake_jobs *jobs,
+    bake_job_cb action,
+    void *ctx)
+{
+    bake_job *job = ut_calloc(sizeof(bake_job));
+    job->jobs = jobs;
+    job->action = action;
+    job->ctx = ctx;
+
+    /* If jobs are not started, the set runs when bake_jobs_wait is called */
+    if (!bake_jobs_queue) {
+        bake_jobs_queue = ut_ll_new();
+    }
+
+    ut_ll_append(bake_jobs_queue, job);
+    jobs->pending ++;
+
+    if (bake_jobs_worker_count) {
+        ut_cond_signal(&bake_jobs_cond);
+    }
+}
+
+int16_t bake_jobs_wait(
+    bake_jobs *jobs)
+{
+    int16_t result;
+
+    /* Only run jobs from own set while waiting, so a job that waits for its
+     * own jobs does not get stuck behind unrelated work. */
+    while (jobs->pending) {
+        bake_job *job = bake_jobs_take(jobs);
+        if (job) {
+            bake_jobs_run(job);
+        } else {
+            ut_cond_wait(&bake_jobs_cond, &bake_jobs_lock);
+        }
+    }
+
+    result = jobs->result;
+    free(jobs);
+
+    return result;
+}
+
+bool bake_jobs_suspend(void)
+{
+    if (!bake_jobs_worker_count) {
+        return false;
+    }
+
+    /* Drivers may temporarily change the working directory of the process.
+     * Other jobs use relative paths, so they can't run until it is restored. */
+    if (strcmp(ut_cwd(), bake_jobs_cwd)) {
+        return false;
+    }
+
+    ut_mutex_unlock(&bake_jobs_lock);
+
+    return true;
+}
+
+void bake_jobs_resume(void)
+{
+    ut_mutex_lock(&bake_jobs_lock);
+}
+
+void bake_jobs_output(
+    FILE *out)
+{
+    ut_strbuf *log = ut_log_captured();
+    char buf[4096];
+    size_t len;
+
+    rewind(out);
+    while ((len = fread(buf, 1, sizeof(buf), out))) {
+        if (log) {
+            ut_strbuf_appendstrn(log, buf, len);
+        } else {
+            fwrite(buf, 1, len, stdout);
+        }
+    }
+
+    fclose(out);
+}
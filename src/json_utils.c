@@ -36,6 +36,23 @@ int16_t bake_json_set_boolean(
     return 0;
 }
 
+int16_t bake_json_set_uint32(
+    uint32_t *ptr,
+    const char *member,
+    JSON_Value *v)
+{
+    if (json_value_get_type(v) != JSONNumber ||
+        json_value_get_number(v) < 0)
+    {
+        ut_throw("expected positive number for member '%s'", member);
+        return -1;
+    }
+
+    *ptr = json_value_get_number(v);
+
+    return 0;
+}
+
 int16_t bake_json_set_string(
     char **ptr,
     const char *member,
@@ -54,6 +54,8 @@ bool optimize = false;
 bool loop_test = false;
 bool assembly = false;
 bool profile_build = false;
+bool object_cache = false;
+int jobs = 1;
 
 bool is_test = false;
 bool to_env = false;
@@ -78,6 +80,11 @@ const char *use_expr = NULL;
 const char *publish_cmd = NULL;
 const char *run_prefix = NULL;
 const char *test_prefix = NULL;
+const char *test_shard = NULL;
+int test_jobs = 0;
+bool test_changed = false;
+const char *test_report_json = NULL;
+const char *test_report_junit = NULL;
 bool interactive = false;
 bool recursive = false;
 int run_argc = 0;
@@ -122,6 +129,8 @@ void bake_usage(void)
     printf("  --optimize                   Manually enable compiler optimizations\n");
     printf("  --loop-test                  Manually enable vectorization analysis\n");
     printf("  --profile-build              Manually enable build profiling\n");
+    printf("  -j,--jobs <count>            Number of jobs to run in parallel (default = 1)\n");
+    printf("  --cache                      Reuse objects from the bake object cache\n");
     printf("\n");
     printf("  --package                    Set the project type to package\n");
     printf("  --template                   Set the project type to template\n");
@@ -142,6 +151,11 @@ void bake_usage(void)
     printf("  --interactive                Rebuild project when files change (use with run)\n");
     printf("  --run-prefix                 Specify prefix command for run\n");
     printf("  --test-prefix                Specify prefix command for tests run by test\n");
+    printf("  --shard <index>/<count>      Only run one of count slices of testcases (use with test)\n");
+    printf("  --test-jobs <count>          Total number of test threads for all projects (default = 8)\n");
+    printf("  --changed                    Only test projects that changed since their tests last passed\n");
+    printf("  --report-json <file>         Stream test results as JSON lines, one file per project\n");
+    printf("  --report-junit <file>        Write test results as JUnit XML, one file per project\n");
     printf("  --fast                       Don't add any instrumentations to test builds\n");
     printf("  -r,--recursive               Recursively build all dependencies of discovered projects\n");
     printf("  -t [id]                      Specify template for new project\n");
@@ -170,6 +184,7 @@ void bake_usage(void)
     printf("  use <project:bundle>         Configure the environment to use specified bundle\n");
     printf("  update [project id]          Update an installed package or application\n");
     printf("  foreach <cmd>                Run command for each discovered project\n");
+    printf("  daemon [path]                Build projects on request of bake clients (Linux only)\n");
     printf("\n");
     printf("  env                          Echo bake environment\n");
     printf("  upgrade                      Upgrade to new bake version\n");
@@ -276,7 +291,8 @@ int16_t bake_init_action(
         !strcmp(arg, "use") ||
         !strcmp(arg, "unuse") ||
         !strcmp(arg, "export") ||
-        !strcmp(arg, "unset"))
+        !strcmp(arg, "unset") ||
+        !strcmp(arg, "daemon"))
     {
         discover = false;
         build = false;
@@ -319,6 +335,8 @@ int bake_parse_args(
             ARG(0, "optimize", optimize = true );
             ARG(0, "loop-test", loop_test = true );
             ARG(0, "assembly", assembly = true );
+            ARG('j', "jobs", jobs = atoi(argv[i + 1]); i ++);
+            ARG(0, "cache", object_cache = true);
 
             ARG(0, "trace", ut_log_verbositySet(UT_TRACE));
             ARG(0, "debug", ut_log_verbositySet(UT_DEBUG));
@@ -347,6 +365,11 @@ int bake_parse_args(
             ARG(0, "fast", fast_build = true);
             ARG(0, "run-prefix", run_prefix = argv[i + 1]; i++);
             ARG(0, "test-prefix", test_prefix = argv[i + 1]; i++);
+            ARG(0, "shard", test_shard = argv[i + 1]; i++);
+            ARG(0, "test-jobs", test_jobs = atoi(argv[i + 1]); i++);
+            ARG(0, "changed", test_changed = true);
+            ARG(0, "report-json", test_report_json = argv[i + 1]; i++);
+            ARG(0, "report-junit", test_report_junit = argv[i + 1]; i++);
             ARG('i', "interactive", interactive = true);
             ARG('r', "recursive", recursive = true);
             ARG('a', "args", run_argc = argc - i; run_argv = &argv[i + 1]; break);
@@ -412,6 +435,17 @@ int bake_parse_args(
     if (!strcmp(action, "test")) {
         test = true;
         cfg = "test";
+
+        if (test_shard) {
+            unsigned int shard_index, shard_count;
+            if (sscanf(test_shard, "%u/%u", &shard_index, &shard_count) != 2 ||
+                !shard_index || shard_index > shard_count)
+            {
+                ut_throw("invalid value '%s' for --shard (expected index/count, "
+                    "starting from 1/count)", test_shard);
+                goto error;
+            }
+        }
     }
 
     else if (!strcmp(action, "export") || !strcmp(action, "unset")) {
@@ -543,6 +577,96 @@ error:
     return -1;
 }
 
+/* Print statistics of object cache, if it was used */
+static
+void bake_report_object_cache(
+    bake_config *config)
+{
+    uint32_t hits = config->object_cache_hits;
+    uint32_t total = hits + config->object_cache_misses;
+    if (!config->object_cache || !total) {
+        return;
+    }
+
+    bake_message(UT_LOG, "cache", "%u hits, %u misses #[grey](%u%% hit rate)",
+        hits, config->object_cache_misses, 100 * hits / total);
+}
+
+/* Signature of options that affect the build, used by the daemon to test if a
+ * client builds with the same configuration */
+static
+char* bake_daemon_signature(void)
+{
+    ut_strbuf buf = UT_STRBUF_INIT;
+    ut_strbuf_append(&buf, "%s:%s:%s:%s:%s:%d%d%d%d%d%d%d%d:%d",
+        cfg ? cfg : "", env, target ? target : "",
+        env_cc ? env_cc : "", env_cxx ? env_cxx : "",
+        strict, optimize, loop_test, assembly, profile_build, object_cache,
+        fast_build, recursive, jobs);
+
+    ut_iter it = ut_ll_iter(defines);
+    while (ut_iter_hasNext(&it)) {
+        ut_strbuf_append(&buf, ":%s", ut_iter_next(&it));
+    }
+
+    return ut_strbuf_get(&buf);
+}
+
+/* Paths of projects found by last discovery of daemon */
+static ut_ll daemon_paths;
+
+static
+void bake_daemon_free_paths(void)
+{
+    if (daemon_paths) {
+        char *project_path;
+        while ((project_path = ut_ll_takeFirst(daemon_paths))) {
+            free(project_path);
+        }
+        ut_ll_free(daemon_paths);
+        daemon_paths = NULL;
+    }
+}
+
+/* Build projects for daemon request. Projects are loaded from the paths found
+ * by the last discovery, unless the daemon detected changes in the directory
+ * tree. Projects are always created again, so that each build starts from a
+ * fresh project state. Their project.json is only parsed again when it
+ * changed. */
+static
+int16_t bake_daemon_build(
+    bake_config *config,
+    const char *action,
+    bool rediscover)
+{
+    config->object_cache_hits = 0;
+    config->object_cache_misses = 0;
+
+    bake_crawler_free();
+    bake_crawler_init();
+
+    if (rediscover || !daemon_paths) {
+        bake_daemon_free_paths();
+        ut_try( bake_discovery(config), "discovery failed");
+        daemon_paths = bake_crawler_paths();
+    } else {
+        ut_try( bake_crawler_add_paths(config, daemon_paths), NULL);
+    }
+
+    if (bake_crawler_count()) {
+        ut_log_push("build");
+        int16_t ret = bake_build(config, action);
+        ut_log_pop();
+        bake_report_object_cache(config);
+        ut_try(ret, NULL);
+    }
+
+    return 0;
+error:
+    bake_daemon_free_paths();
+    return -1;
+}
+
 /* Print environment to stdout */
 int bake_env(
     bake_config *config)
@@ -1189,6 +1313,23 @@ int bake_foreach_action(
     return result || ret;
 }
 
+/* Test executables run in their project directory, so pass reports as absolute
+ * paths. The test framework inserts the project id into the file name. */
+static
+void bake_set_report_env(
+    const char *var,
+    const char *file)
+{
+    if (ut_path_is_relative(file)) {
+        char *path = ut_asprintf("%s"UT_OS_PS"%s", ut_cwd(), file);
+        ut_path_clean(path, path);
+        ut_setenv(var, path);
+        free(path);
+    } else {
+        ut_setenv(var, file);
+    }
+}
+
 /* Test all discovered projects */
 int bake_test_action(
     bake_config *config,
@@ -1198,17 +1339,54 @@ int bake_test_action(
     int result = 0;
 
     if (ut_file_test(test_path) == 1) {
-        int8_t rc;
-        
+        int8_t rc = 0;
+        int sig = -1;
+        FILE *out = NULL;
+
+        /* Determine state before running tests, as tests may create files */
+        if (test_changed && !bake_changes_test_outdated(config, project)) {
+            bake_message(UT_LOG, "skip",
+                "#[green]package#[reset] %s (no changes since tests passed)",
+                project->id);
+            free(test_path);
+            return 0;
+        }
+
         bake_project_test(config, project);
 
         char *cmd = ut_asprintf("bake runall %s --cfg test", test_path);
-        int sig = ut_proc_cmd(cmd, &rc);
+
+        /* When projects are tested in parallel, collect the test output so it
+         * is printed in one piece with the rest of the project output */
+        if (config->jobs > 1) {
+            out = tmpfile();
+        }
+
+        ut_proc pid = ut_proc_runRedirect("bake", (const char*[]){
+            "bake", "runall", test_path, "--cfg", "test", NULL
+        }, stdin, out ? out : stdout, out ? out : stderr);
+
+        if (pid) {
+            bool suspended = bake_jobs_suspend();
+            sig = ut_proc_wait(pid, &rc);
+            if (suspended) {
+                bake_jobs_resume();
+            }
+        }
+
+        if (out) {
+            bake_jobs_output(out);
+        }
 
         if (sig || rc) {
+            ut_catch();
             ut_error("command '%s' failed", cmd);
             result = -1;
+        } else if (test_changed && bake_changes_test_passed(config, project)) {
+            ut_catch();
         }
+
+        free(cmd);
     }
 
     free (test_path);
@@ -1364,6 +1542,11 @@ int main(int argc, const char *argv[]) {
 
     ut_try (bake_parse_args(argc, argv), NULL);
 
+    /* Remember file status for the duration of the command, so that files
+     * that are checked by multiple projects or build steps are only stat'ed
+     * once */
+    ut_stat_cache_enable(true);
+
     if (ut_log_verbosityGet() <= UT_DEBUG) {
         ut_log_fmt("%f:%l: %C %V %m");
     } else {
@@ -1449,6 +1632,8 @@ int main(int argc, const char *argv[]) {
         .environment = env,
         .symbols = true,
         .debug = true,
+        .jobs = jobs > 1 ? jobs : 1,
+        .object_cache_size = 5 * 1024,
         .bake_modified = bake_modified
     };
 
@@ -1458,6 +1643,20 @@ int main(int argc, const char *argv[]) {
         goto ok;
     }
 
+    /* If a daemon is running for the path, let the daemon do the build */
+    if (discover && build && !id && !ut_getenv("BAKE_DAEMON") && (
+        !strcmp(action, "build") || !strcmp(action, "rebuild") ||
+        !strcmp(action, "clean")))
+    {
+        char *signature = bake_daemon_signature();
+        int rc = bake_daemon_request(path, action, signature);
+        free(signature);
+        if (rc != -1) {
+            ut_deinit();
+            return rc ? UT_CMD_ERR : UT_CMD_OK;
+        }
+    }
+
     if (recursive) {
         /* If this is a recursive build, load bundles in case there are
          * repositories in the dependency tree that need to be cloned */
@@ -1492,6 +1691,9 @@ int main(int argc, const char *argv[]) {
     if (profile_build) {
         config.profile_build = true;
     }
+    if (object_cache) {
+        config.object_cache = true;
+    }
     if (assembly) {
         config.assembly = true;
     }
@@ -1590,8 +1792,10 @@ int main(int argc, const char *argv[]) {
         if (count) {
             if (build) {
                 ut_log_push("build");
-                ut_try(bake_build(&config, action), NULL);
+                int16_t ret = bake_build(&config, action);
                 ut_log_pop();
+                bake_report_object_cache(&config);
+                ut_try(ret, NULL);
             } else {
                 if (!strcmp(action, "foreach")) {
                     ut_try( bake_crawler_walk(
@@ -1603,6 +1807,27 @@ int main(int argc, const char *argv[]) {
                     if (test_prefix) {
                         ut_setenv("BAKE_TEST_PREFIX", test_prefix);
                     }
+                    if (test_shard) {
+                        ut_setenv("BAKE_TEST_SHARD", test_shard);
+                    }
+                    if (test_report_json) {
+                        bake_set_report_env(
+                            "BAKE_TEST_REPORT_JSON", test_report_json);
+                    }
+                    if (test_report_junit) {
+                        bake_set_report_env(
+                            "BAKE_TEST_REPORT_JUNIT", test_report_junit);
+                    }
+
+                    /* Divide test threads over projects tested in parallel,
+                     * so that the total doesn't exceed the number of test
+                     * threads (8 by default, same as the test executable) */
+                    if (test_jobs || jobs > 1) {
+                        int per_project = (test_jobs ? test_jobs : 8) /
+                            (jobs > 1 ? jobs : 1);
+                        ut_setenv("BAKE_TEST_JOBS", "%d",
+                            per_project > 1 ? per_project : 1);
+                    }
                     ut_try( bake_crawler_walk(
                         &config, action, bake_test_action), NULL);
                 } else if (!strcmp(action, "runall")) {
@@ -1667,6 +1892,13 @@ int main(int argc, const char *argv[]) {
             ut_try (bake_use(&config, use_expr, true, false), NULL);
         } else if (!strcmp(action, "unuse")) {
             ut_try (bake_unuse(&config, use_expr), NULL);            
+        } else if (!strcmp(action, "daemon")) {
+            char *signature = bake_daemon_signature();
+            int16_t ret = bake_daemon_run(
+                &config, path, signature, bake_daemon_build);
+            free(signature);
+            bake_daemon_free_paths();
+            ut_try (ret, NULL);
         } else if (!strcmp(action, "upgrade")) {
             ut_log("#[bold]Cannot upgrade bake while bake is running\n");
             printf("  This is likely happening because the bake environment is exported. To\n");
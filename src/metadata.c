@@ -0,0 +1,225 @@
+/* Copyright (c) 2010-2019 Sander Mertens
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "bake.h"
+
+/* Process-wide cache with the project.json and dependee.json files of projects
+ * that bake loaded, so that a project that is a dependency of many other
+ * projects is only parsed once. Entries are keyed by project location (as
+ * returned by ut_locate for the package id) and are loaded again when the
+ * modification time of a file changes. Projects are created for a config, and
+ * are created again when they are requested for another config, which can
+ * happen when the daemon serves requests with different configurations. */
+
+typedef struct bake_metadata {
+    char *path;
+    time_t modified;            /* Modification time of project.json */
+    JSON_Value *json;           /* Parsed project.json */
+    bake_project *project;      /* Project for looking up dependency info */
+    char *project_config;       /* Config for which project was created */
+    time_t dependee_modified;   /* Modification time of dependee.json */
+    JSON_Value *dependee;       /* Parsed dependee.json */
+} bake_metadata;
+
+static ut_rb bake_metadata_cache;
+
+static
+int bake_metadata_compare(
+    void *ctx,
+    const void* key1,
+    const void* key2)
+{
+    return strcmp(key1, key2);
+}
+
+static
+void bake_metadata_clear(
+    bake_metadata *entry)
+{
+    if (entry->json) {
+        json_value_free(entry->json);
+        entry->json = NULL;
+    }
+    if (entry->project) {
+        bake_project_free(entry->project);
+        entry->project = NULL;
+    }
+    free(entry->project_config);
+    entry->project_config = NULL;
+    if (entry->dependee) {
+        json_value_free(entry->dependee);
+        entry->dependee = NULL;
+    }
+    entry->modified = 0;
+    entry->dependee_modified = 0;
+}
+
+/* Find entry for project, and drop project.json if it changed */
+static
+bake_metadata* bake_metadata_get(
+    const char *path)
+{
+    char *file = ut_asprintf("%s"UT_OS_PS"project.json", path);
+    time_t modified = ut_lastmodified(file);
+    free(file);
+
+    if (modified == -1) {
+        goto error;
+    }
+
+    if (!bake_metadata_cache) {
+        bake_metadata_cache = ut_rb_new(bake_metadata_compare, NULL);
+    }
+
+    bake_metadata *entry = ut_rb_find(bake_metadata_cache, path);
+    if (!entry) {
+        entry = ut_calloc(sizeof(bake_metadata));
+        entry->path = ut_strdup(path);
+        ut_rb_set(bake_metadata_cache, entry->path, entry);
+    } else if (entry->modified != modified) {
+        bake_metadata_clear(entry);
+    }
+
+    entry->modified = modified;
+
+    return entry;
+error:
+    return NULL;
+}
+
+JSON_Value* bake_metadata_json(
+    const char *path)
+{
+    bake_metadata *entry = bake_metadata_get(path);
+    if (!entry) {
+        goto error;
+    }
+
+    if (!entry->json) {
+        char *file = ut_asprintf("%s"UT_OS_PS"project.json", path);
+        entry->json = json_parse_file_with_comments(file);
+        if (!entry->json) {
+            ut_throw("failed to parse '%s'", file);
+            free(file);
+            goto error;
+        }
+        free(file);
+    }
+
+    return json_value_deep_copy(entry->json);
+error:
+    return NULL;
+}
+
+bake_project* bake_metadata_project(
+    bake_config *config,
+    const char *path)
+{
+    bake_metadata *entry = bake_metadata_get(path);
+    if (!entry) {
+        goto error;
+    }
+
+    /* Target path contains the platform and configuration */
+    char *config_id = ut_asprintf("%s:%s", config->target, config->environment);
+    if (entry->project && strcmp(entry->project_config, config_id)) {
+        bake_project_free(entry->project);
+        entry->project = NULL;
+    }
+
+    if (!entry->project) {
+        entry->project = bake_project_new(path, config);
+        if (!entry->project) {
+            free(config_id);
+            goto error;
+        }
+
+        free(entry->project_config);
+        entry->project_config = config_id;
+    } else {
+        free(config_id);
+    }
+
+    return entry->project;
+error:
+    return NULL;
+}
+
+int16_t bake_metadata_dependee(
+    const char *path,
+    JSON_Object **dependee_out)
+{
+    char *file = ut_asprintf("%s"UT_OS_PS"dependee.json", path);
+    bake_metadata *entry;
+    time_t modified;
+
+    *dependee_out = NULL;
+
+    if (ut_file_test(file) != 1) {
+        goto done;
+    }
+
+    if (!(entry = bake_metadata_get(path))) {
+        goto error;
+    }
+
+    if ((modified = ut_lastmodified(file)) == -1) {
+        goto error;
+    }
+
+    if (entry->dependee && entry->dependee_modified != modified) {
+        json_value_free(entry->dependee);
+        entry->dependee = NULL;
+    }
+
+    if (!entry->dependee) {
+        JSON_Value *json = json_parse_file_with_comments(file);
+        if (!json_value_get_object(json)) {
+            ut_throw("failed to parse '%s' (expected object)", file);
+            if (json) {
+                json_value_free(json);
+            }
+            goto error;
+        }
+        entry->dependee = json;
+        entry->dependee_modified = modified;
+    }
+
+    *dependee_out = json_value_get_object(entry->dependee);
+done:
+    free(file);
+    return 0;
+error:
+    free(file);
+    return -1;
+}
+
+void bake_metadata_invalidate(
+    const char *path)
+{
+    if (bake_metadata_cache) {
+        bake_metadata *entry = ut_rb_find(bake_metadata_cache, path);
+        if (entry) {
+            bake_metadata_clear(entry);
+        }
+    }
+}
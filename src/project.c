@@ -487,16 +487,19 @@ error:
     return -1;
 }
 
-/* Parse project.json  */
+/* Parse project.json, or use contents that were already parsed */
 static
 int16_t bake_project_parse(
     bake_config *config,
-    bake_project *project)
+    bake_project *project,
+    JSON_Value *j)
 {
     char *file = ut_asprintf("%s"UT_OS_PS"project.json", project->path);
 
-    if (ut_file_test(file) == 1) {
-        JSON_Value *j = json_parse_file_with_comments(file);
+    if (j || ut_file_test(file) == 1) {
+        if (!j) {
+            j = bake_metadata_json(project->path);
+        }
         if (!j) {
             ut_throw("failed to parse '%s'", file);
             goto error;
@@ -699,14 +702,12 @@ int16_t bake_project_add_dependee_config(
     const char *libpath = ut_locate(dependency, NULL, UT_LOCATE_PROJECT);
     if (libpath) {
         /* Check if dependency has a dependee file with build instructions */
-        char *file = ut_asprintf("%s"UT_OS_PS"dependee.json", libpath);
-        if (ut_file_test(file)) {
-            ut_try (
-              bake_project_load_dependee_config(config, project, dependency, file),
-              NULL);
+        JSON_Object *dependee;
+        ut_try( bake_metadata_dependee(libpath, &dependee), NULL);
+        if (dependee) {
+            ut_try( bake_project_load_dependee_object(
+                config, project, dependency, dependee), NULL);
         }
-
-        free(file);
     } else {
         /* If dependency cannot be found at this time, it is either a missing
          * dependency (in which case an error will be thrown) or it is a project
@@ -949,6 +950,15 @@ error:
 bake_project* bake_project_new(
     const char *path,
     bake_config *config)
+{
+    return bake_project_new_w_json(path, config, NULL);
+}
+
+/* Create new project from path with parsed project.json */
+bake_project* bake_project_new_w_json(
+    const char *path,
+    bake_config *config,
+    JSON_Value *json)
 {
     bake_project *result = ut_calloc(sizeof (bake_project));
     if (!path && !config) {
@@ -962,7 +972,7 @@ bake_project* bake_project_new(
     /* Parse project.json if available */
     if (path) {
         ut_try (
-            bake_project_parse(config, result),
+            bake_project_parse(config, result, json),
             "failed to parse '%s"UT_OS_PS"project.json'",
             path);
 
@@ -1434,7 +1444,8 @@ int16_t bake_check_dependency(
     bool dep_has_lib = false;
 
     if (path) {
-        dep = bake_project_new(path, config);
+        /* Dependency is only used for reading, so get it from the cache */
+        dep = bake_metadata_project(config, path);
         if (!dep) {
             ut_throw("failed to create project from path '%s'", path);
             goto error;
@@ -1497,9 +1508,6 @@ int16_t bake_check_dependency(
     }
 
 proceed:
-    if (dep) {
-        bake_project_free(dep);
-    }
     return 0;
 error:
     return -1;
@@ -2361,6 +2369,7 @@ int16_t bake_project_create_gitignore(
     fprintf(f, "bin\n");
 
     fclose(f);
+    ut_stat_cache_invalidate(".gitignore");
 
     return 0;
 error:
@@ -2432,6 +2441,7 @@ int16_t bake_project_file_from_template(
 
     fprintf(dst, "%s", dst_content);
     fclose(dst);
+    ut_stat_cache_invalidate(dst_file);
 
     free(dst_content);
     free(src_content);
@@ -24,6 +24,13 @@ bake_project* bake_project_new(
     const char *path,
     bake_config *cfg);
 
+/** Create new project from project.json contents that were already parsed.
+ * The project takes ownership of the JSON value. */
+bake_project* bake_project_new_w_json(
+    const char *path,
+    bake_config *cfg,
+    JSON_Value *json);
+
 /* Initialize project that wasn't loaded from a project.json */
 int16_t bake_project_init(
     bake_config *config,
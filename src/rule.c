@@ -94,6 +94,7 @@ bake_dependency_rule* bake_dependency_rule_new(
     bake_rule_action_cb action)
 {
     bake_dependency_rule *result = ut_calloc(sizeof(bake_dependency_rule));
+    result->super.kind = BAKE_RULE_DEPENDENCY;
     result->super.name = name;
     result->super.cond = NULL;
     result->target = dep_mapping;
@@ -201,6 +202,353 @@ error:
     return NULL;
 }
 
+/* Find dependency rule that loads dependencies for targets of a rule */
+static
+bake_dependency_rule* bake_node_find_dependency_rule(
+    bake_driver *driver,
+    bake_rule *r)
+{
+    ut_iter it = ut_ll_iter(driver->nodes);
+    while (ut_iter_hasNext(&it)) {
+        bake_node *n = ut_iter_next(&it);
+        if (n->kind == BAKE_RULE_DEPENDENCY) {
+            bake_dependency_rule *dr = (bake_dependency_rule*)n;
+            if (dr->deps && dr->deps[0] == '$' &&
+                !strcmp(&dr->deps[1], r->super.name))
+            {
+                return dr;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* Load files from a make-style dependency file (as generated by gcc -MMD).
+ * Relative paths in the file are relative to the directory the compiler ran
+ * in, which is provided by dep_cwd if it is not the current directory. */
+static
+void bake_node_load_dependencies(
+    const char *dep_file,
+    const char *dep_cwd,
+    ut_ll files)
+{
+    char *content = ut_file_load(dep_file);
+    if (!content) {
+        ut_raise();
+        return;
+    }
+
+    /* Skip target. Don't stop at a ':' that is part of a (Windows) path */
+    char *ptr = content, ch;
+    while ((ch = *ptr) && !(ch == ':' && (!ptr[1] || isspace(ptr[1])))) {
+        ptr ++;
+    }
+
+    ut_strbuf buf = UT_STRBUF_INIT;
+
+    while (ch) {
+        /* Skip whitespace and line continuations */
+        ptr ++;
+        while ((ch = *ptr) && (isspace(ch) ||
+            (ch == '\\' && (ptr[1] == '\n' || ptr[1] == '\r'))))
+        {
+            ptr ++;
+        }
+
+        if (!ch) {
+            break;
+        }
+
+        /* Read file name, unescape spaces */
+        for (; (ch = *ptr) && !isspace(ch); ptr ++) {
+            if (ch == '\\' && ptr[1] == ' ') {
+                ptr ++;
+                ch = ' ';
+            } else if (ch == '$' && ptr[1] == '$') {
+                ptr ++;
+            } else if (ch == '\\' && (ptr[1] == '\n' || ptr[1] == '\r')) {
+                break;
+            }
+            ut_strbuf_appendstrn(&buf, &ch, 1);
+        }
+
+        char *file = ut_strbuf_get(&buf);
+        if (file && dep_cwd && ut_path_is_relative(file)) {
+            char *abs_file = ut_asprintf("%s"UT_OS_PS"%s", dep_cwd, file);
+            free(file);
+            file = abs_file;
+        }
+        if (file) {
+            ut_ll_append(files, file);
+        }
+    }
+
+    free(content);
+}
+
+/* Collect files that a target depends on. This is the source of the target,
+ * and if a dependency rule is set, the files in its dependency file. */
+static
+ut_ll bake_node_target_inputs(
+    bake_project *p,
+    bake_config *c,
+    bake_dependency_rule *dr,
+    const char *dep_cwd,
+    const char *srcPath,
+    bake_file *dst)
+{
+    ut_ll result = ut_ll_new();
+    ut_ll_append(result, ut_strdup(srcPath));
+
+    if (!dr) {
+        return result;
+    }
+
+    char *dep_file = dr->target.is.map(
+        &bake_driver_api_impl, c, p, dst->file_path);
+    if (!dep_file) {
+        return result;
+    }
+
+    if (dr->action && ut_file_test(dep_file) != 1) {
+        ut_stat_cache_suspend();
+        dr->action(&bake_driver_api_impl, c, p, dst->file_path, dep_file);
+        ut_stat_cache_resume();
+    }
+
+    if (ut_file_test(dep_file) == 1) {
+        bake_node_load_dependencies(dep_file, dep_cwd, result);
+    } else {
+        ut_trace("#[grey]no dependency file for %s", dst->name);
+    }
+
+    free(dep_file);
+
+    return result;
+}
+
+static
+void bake_node_free_inputs(
+    ut_ll inputs)
+{
+    char *file;
+    while ((file = ut_ll_takeFirst(inputs))) {
+        free(file);
+    }
+    ut_ll_free(inputs);
+}
+
+/* Test if any of the inputs is newer than the target. Inputs that no longer
+ * exist also cause the target to be rebuilt, as a header may have moved. */
+static
+bool bake_node_inputs_newer(
+    ut_ll inputs,
+    const char *target,
+    time_t timestamp)
+{
+    ut_iter it = ut_ll_iter(inputs);
+    while (ut_iter_hasNext(&it)) {
+        char *file = ut_iter_next(&it);
+        if (ut_file_test(file) != 1) {
+            ut_catch();
+            ut_trace("#[grey]%s no longer exists, rebuilding %s",
+                file, target);
+            return true;
+        } else if (ut_lastmodified(file) > timestamp) {
+            ut_trace("#[grey]%s is newer than %s, rebuilding",
+                file, target);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Signature of the command that built a target. The signature is stored next
+ * to the target, so it is removed when the target is cleaned. Commands (and
+ * dependency files) contain paths relative to the working directory, which is
+ * stored on the first line. Returns false if target has no signature. */
+static
+bool bake_node_read_signature(
+    const char *target,
+    char **cwd_out,
+    char **cmd_out)
+{
+    char *sig_file = ut_asprintf("%s.cmd", target);
+    char *sig = NULL, *cmd = NULL;
+
+    if (ut_file_test(sig_file) == 1) {
+        sig = ut_file_load(sig_file);
+        cmd = sig ? strchr(sig, '\n') : NULL;
+    }
+
+    ut_catch();
+    free(sig_file);
+
+    if (!cmd) {
+        free(sig);
+        return false;
+    }
+
+    cmd[0] = '\0';
+    *cwd_out = sig;
+    *cmd_out = cmd + 1;
+
+    return true;
+}
+
+static
+void bake_node_write_signature(
+    const char *target,
+    const char *cmd)
+{
+    char *sig_file = ut_asprintf("%s.cmd", target);
+    FILE *f = fopen(sig_file, "w");
+    if (f) {
+        fprintf(f, "%s\n%s", ut_cwd(), cmd);
+        fclose(f);
+        ut_stat_cache_invalidate(sig_file);
+    } else {
+        ut_trace("#[grey]failed to write signature '%s'", sig_file);
+    }
+    free(sig_file);
+}
+
+bool bake_node_target_outdated(
+    const char *target,
+    const char *dep_file,
+    const char *cmd)
+{
+    char *sig_cwd = NULL, *prev_cmd = NULL;
+    bool result = true;
+
+    if (ut_file_test(target) != 1) {
+        ut_catch();
+        return true;
+    }
+
+    if (!bake_node_read_signature(target, &sig_cwd, &prev_cmd)) {
+        ut_trace("#[grey]no signature for %s, rebuilding", target);
+        return true;
+    }
+
+    /* Commands from another working directory can't be compared */
+    if (strcmp(sig_cwd, ut_cwd()) || strcmp(prev_cmd, cmd)) {
+        ut_trace("#[grey]command for %s changed, rebuilding", target);
+    } else if (ut_file_test(dep_file) != 1) {
+        ut_catch();
+        ut_trace("#[grey]no dependency file for %s, rebuilding", target);
+    } else {
+        ut_ll inputs = ut_ll_new();
+        bake_node_load_dependencies(dep_file, NULL, inputs);
+        result = bake_node_inputs_newer(
+            inputs, target, ut_lastmodified(target));
+        bake_node_free_inputs(inputs);
+    }
+
+    free(sig_cwd);
+
+    return result;
+}
+
+void bake_node_target_built(
+    const char *target,
+    const char *cmd)
+{
+    bake_node_write_signature(target, cmd);
+}
+
+typedef struct bake_rule_map_job {
+    bake_project *project;
+    bake_config *config;
+    bake_rule *rule;
+    bake_dependency_rule *dep_rule;
+    bake_builddb *db;
+    bake_file *src;
+    bake_file *dst;
+    char *src_path;
+    char *command;
+    int percentage;
+} bake_rule_map_job;
+
+static
+void bake_rule_map_job_free(
+    bake_rule_map_job *job)
+{
+    free(job->src_path);
+    free(job->command);
+    free(job);
+}
+
+static
+int16_t bake_node_run_rule_map_job(
+    void *ctx)
+{
+    bake_rule_map_job *job = ctx;
+    bake_project *p = job->project;
+    bake_file *src = job->src, *dst = job->dst;
+
+    /* Don't start new tasks once a task has failed */
+    if (p->error) {
+        bake_rule_map_job_free(job);
+        return 0;
+    }
+
+    char counter[16];
+    sprintf(counter, "%d%%", job->percentage);
+    bake_message(UT_LOG, counter, src->name);
+
+    /* Make sure target directory exists */
+    ut_try (bake_assertPathForFile(dst->path), NULL);
+
+    /* Invoke action. Drivers don't update the stat cache of bake when they
+     * write files, so don't use it while driver code runs. */
+    ut_stat_cache_suspend();
+    job->rule->action(
+        &bake_driver_api_impl, job->config, p, job->src_path, dst->file_path);
+    ut_stat_cache_resume();
+
+    /* Check if error flag was set. Other tasks may run while this task waits
+     * for its command, so only report the error if it was thrown here. */
+    if (p->error) {
+        if (ut_raised()) {
+            ut_throw("command for task '%s' failed", src->name);
+            goto error;
+        }
+    } else {
+        p->freshly_baked = true;
+        p->changed = true;
+    }
+
+    /* Update target with latest timestamp */
+    if (ut_file_test(dst->name) == 1) {
+        dst->timestamp = ut_lastmodified(dst->name);
+    } else {
+        dst->timestamp = 0;
+    }
+
+    /* Record command and (possibly new) inputs of target */
+    if (!p->error) {
+        ut_ll inputs = bake_node_target_inputs(
+            p, job->config, job->dep_rule, NULL, job->src_path, dst);
+        bake_builddb_set(job->db, dst->file_path, inputs);
+        bake_node_free_inputs(inputs);
+
+        if (job->command) {
+            bake_node_write_signature(dst->file_path, job->command);
+        }
+    }
+
+    bake_rule_map_job_free(job);
+    return 0;
+error:
+    /* Tasks may run in another thread, so report error where it happened */
+    ut_raise();
+    bake_rule_map_job_free(job);
+    return -1;
+}
+
 static
 int16_t bake_node_run_rule_map(
     bake_driver *driver,
@@ -210,6 +558,9 @@ int16_t bake_node_run_rule_map(
     bake_filelist *inputs,
     bake_filelist *targets)
 {
+    bake_dependency_rule *dr = bake_node_find_dependency_rule(driver, r);
+    bake_builddb *db = bake_builddb_load(c, p);
+    bake_jobs *jobs = bake_jobs_new();
     ut_iter it = bake_filelist_iter(inputs);
     int count = 0;
     while (ut_iter_hasNext(&it)) {
@@ -217,8 +568,15 @@ int16_t bake_node_run_rule_map(
         bake_file *dst = NULL;
         const char *map = r->target.is.map(&bake_driver_api_impl, c, p, src->name);
         if (!map) {
-            ut_throw("failed to map file '%s'", src->name);
-            goto error;
+            if (ut_raised()) {
+                ut_throw("failed to map file '%s'", src->name);
+                goto error;
+            }
+
+            /* Input is not mapped to a target of this rule */
+            ut_trace("#[grey]%s excluded from %s", src->name, r->super.name);
+            count ++;
+            continue;
         }
         if (!(dst = bake_filelist_add_file(targets, NULL, map))) {
             ut_throw(NULL);
@@ -226,48 +584,91 @@ int16_t bake_node_run_rule_map(
         }
 
         count ++;
-        if (src->timestamp > dst->timestamp) {
-            char counter[16];
-            sprintf(counter, "%d%%", 100 * count / bake_filelist_count(inputs));
-            bake_message(UT_LOG, counter, src->name);
-
-            /* Make sure target directory exists */
-            ut_try (bake_assertPathForFile(dst->path), NULL);
-
-            /* Invoke action */
-            char *srcPath = src->name;
-            if (src->path) {
-                srcPath = ut_asprintf("%s"UT_OS_PS"%s", src->path, src->name);
-            }
-            r->action(&bake_driver_api_impl, c, p, srcPath, dst->file_path);
-            if (srcPath != src->name) {
-                free(srcPath);
-            }
 
-            /* Check if error flag was set */
-            if (p->error) {
-                ut_throw("command for task '%s' failed", src->name);
-                goto error;
-            } else {
-                p->freshly_baked = true;
-                p->changed = true;
-            }
+        char *srcPath = src->name;
+        if (src->path) {
+            srcPath = ut_asprintf("%s"UT_OS_PS"%s", src->path, src->name);
+        } else {
+            srcPath = ut_strdup(srcPath);
+        }
 
-            /* Update target with latest timestamp */
-            if (ut_file_test(dst->name) == 1) {
-                dst->timestamp = ut_lastmodified(dst->name);
-            } else {
-                dst->timestamp = 0;
-            }
+        /* Commands from another working directory can't be compared */
+        char *sig_cwd = NULL, *prev_cmd = NULL;
+        bool has_sig = dst->timestamp &&
+            bake_node_read_signature(dst->file_path, &sig_cwd, &prev_cmd);
+        const char *dep_cwd = NULL;
+        if (has_sig && strcmp(sig_cwd, ut_cwd())) {
+            dep_cwd = sig_cwd;
+            prev_cmd = NULL;
+        }
+
+        ut_ll target_inputs = bake_node_target_inputs(
+            p, c, dr, dep_cwd, srcPath, dst);
+        char *cmd = NULL;
+        if (r->command) {
+            cmd = r->command(
+                &bake_driver_api_impl, c, p, srcPath, dst->file_path);
+        }
+        bool outdated = src->timestamp > dst->timestamp;
+        if (!outdated) {
+            outdated = bake_node_inputs_newer(
+                target_inputs, dst->name, dst->timestamp);
+        }
+
+        /* Rebuild if the command changed, skip if only timestamps changed */
+        if (prev_cmd && cmd && strcmp(prev_cmd, cmd)) {
+            ut_trace("#[grey]command for %s changed, rebuilding", dst->name);
+            outdated = true;
+        } else if (outdated && prev_cmd && bake_builddb_inputs_unchanged(
+            db, dst->file_path, target_inputs))
+        {
+            ut_trace("#[grey]inputs of %s have not changed", dst->name);
+            outdated = false;
+        } else if (!outdated && dst->timestamp && !has_sig && cmd) {
+            /* Target was built before its signature was recorded */
+            bake_builddb_set(db, dst->file_path, target_inputs);
+            bake_node_write_signature(dst->file_path, cmd);
+        }
+
+        free(sig_cwd);
+        bake_node_free_inputs(target_inputs);
+
+        if (outdated) {
+            /* Tasks run in parallel if more than one job is configured */
+            bake_rule_map_job *job = ut_calloc(sizeof(bake_rule_map_job));
+            job->project = p;
+            job->config = c;
+            job->rule = r;
+            job->dep_rule = dr;
+            job->db = db;
+            job->src = src;
+            job->dst = dst;
+            job->src_path = srcPath;
+            job->command = cmd;
+            job->percentage = 100 * count / bake_filelist_count(inputs);
+            bake_jobs_add(jobs, bake_node_run_rule_map_job, job);
         } else {
             ut_trace("#[grey][%3lld%%] %s",
                 100 * count / bake_filelist_count(inputs),
                 src->name);
+            free(srcPath);
+            free(cmd);
         }
     }
 
-    return 0;
+    int16_t result = bake_jobs_wait(jobs);
+
+    if (bake_builddb_save(db)) {
+        ut_raise();
+    }
+    bake_builddb_free(db);
+
+    return result;
 error:
+    /* Prevent tasks that have already been added from starting */
+    p->error = true;
+    bake_jobs_wait(jobs);
+    bake_builddb_free(db);
     return -1;
 }
 
@@ -342,7 +743,9 @@ int16_t bake_node_run_rule_pattern(
         }
 
         if (r->action) {
+            ut_stat_cache_suspend();
             r->action(&bake_driver_api_impl, c, p, source_list_str, dst);
+            ut_stat_cache_resume();
         }
 
         if (p->error) {
@@ -24,6 +24,12 @@
 #include <sys/stat.h>
 #include <errno.h>
 
+#ifdef UT_OS_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
 static int retcode;
 
 typedef struct ut_fileMonitor {
@@ -134,14 +140,14 @@ int compare_monitor(
     return 1;
 }
 
+/* Test if file (relative to project directory) should trigger a rebuild */
 static
-bool filter_file(
+bool filter_path(
     const char *file)
 {
     char *ext = strrchr(file, '.');
 
-    if (!ut_isdir(file) &&
-        strncmp(file, "test", 4) &&
+    if (strncmp(file, "test", 4) &&
         strncmp(file, "bin", 3) &&
         strcmp(file, "include/bake_config.h") &&
         !(file[0] == '.') &&
@@ -154,6 +160,13 @@ bool filter_file(
     return false;
 }
 
+static
+bool filter_file(
+    const char *file)
+{
+    return !ut_isdir(file) && filter_path(file);
+}
+
 static
 ut_ll gather_files(
     const char *project_dir,
@@ -204,7 +217,7 @@ error:
 }
 
 static
-ut_ll wait_for_changes(
+ut_ll wait_for_changes_poll(
     ut_proc pid,
     const char *project_dir,
     const char *app_bin,
@@ -239,6 +252,8 @@ ut_ll wait_for_changes(
         if (!(i % 20)) {
             bool files_removed = false;
 
+            ut_stat_cache_invalidate(NULL);
+
             /* Refresh files, new files will show up with timestamp 0 */
             files = gather_files(
                 project_dir, app_bin, files, &files_removed);
@@ -259,6 +274,258 @@ ut_ll wait_for_changes(
     return changed;
 }
 
+#ifdef UT_OS_LINUX
+
+#define RUN_WATCH_EVENTS (IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE |\
+    IN_MOVED_FROM | IN_MOVED_TO)
+
+/* Time without events after which a burst of changes is considered done */
+#define RUN_DEBOUNCE (0.1)
+
+/* Maximum time a burst of changes can delay a rebuild */
+#define RUN_DEBOUNCE_MAX (1.0)
+
+typedef struct run_watcher {
+    int fd;
+    const char *project_dir;
+    char **dirs; /* Directory relative to project, indexed by watch descriptor */
+    int32_t dir_count;
+} run_watcher;
+
+/* Watch directory and its subdirectories. The directory is relative to the
+ * project directory, and is NULL for the project directory itself. */
+static
+int16_t run_watcher_add(
+    run_watcher *w,
+    const char *dir)
+{
+    char *dir_path = dir
+        ? ut_asprintf("%s"UT_OS_PS"%s", w->project_dir, dir)
+        : ut_strdup(w->project_dir);
+
+    int wd = inotify_add_watch(w->fd, dir_path, RUN_WATCH_EVENTS);
+    if (wd == -1) {
+        ut_throw("failed to watch '%s': %s", dir_path, strerror(errno));
+        goto error;
+    }
+
+    if (wd >= w->dir_count) {
+        int32_t count = wd + 64;
+        w->dirs = realloc(w->dirs, count * sizeof(char*));
+        memset(&w->dirs[w->dir_count], 0,
+            (count - w->dir_count) * sizeof(char*));
+        w->dir_count = count;
+    }
+
+    free(w->dirs[wd]);
+    w->dirs[wd] = dir ? ut_strdup(dir) : NULL;
+
+    ut_iter it;
+    ut_try (ut_dir_iter(dir_path, NULL, &it), NULL);
+
+    while (ut_iter_hasNext(&it)) {
+        char *file = ut_iter_next(&it);
+        char *file_path = ut_asprintf("%s"UT_OS_PS"%s", dir_path, file);
+        char *sub_dir = dir
+            ? ut_asprintf("%s"UT_OS_PS"%s", dir, file)
+            : ut_strdup(file);
+
+        /* Skip directories that only contain filtered files */
+        if (file[0] != '.' && ut_isdir(file_path) &&
+            strncmp(sub_dir, "test", 4) && strncmp(sub_dir, "bin", 3))
+        {
+            if (run_watcher_add(w, sub_dir)) {
+                free(sub_dir);
+                free(file_path);
+                ut_iter_release(&it);
+                goto error;
+            }
+        }
+
+        free(sub_dir);
+        free(file_path);
+    }
+
+    free(dir_path);
+    return 0;
+error:
+    free(dir_path);
+    return -1;
+}
+
+static
+void run_watcher_free(
+    run_watcher *w)
+{
+    int32_t i;
+    for (i = 0; i < w->dir_count; i ++) {
+        free(w->dirs[i]);
+    }
+    free(w->dirs);
+    close(w->fd);
+}
+
+/* Read pending events. Returns true if one of the events should trigger a
+ * rebuild of the project. */
+static
+bool run_watcher_read(
+    run_watcher *w)
+{
+    char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    bool result = false;
+    ssize_t len;
+
+    while ((len = read(w->fd, buf, sizeof(buf))) > 0) {
+        char *ptr = buf;
+        while (ptr < buf + len) {
+            struct inotify_event *event = (struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                ut_log("#[grey]too many file events, rebuilding\n");
+                result = true;
+                continue;
+            }
+
+            if (!event->len || event->wd < 0 || event->wd >= w->dir_count) {
+                continue;
+            }
+
+            const char *dir = w->dirs[event->wd];
+            char *file = dir
+                ? ut_asprintf("%s"UT_OS_PS"%s", dir, event->name)
+                : ut_strdup(event->name);
+
+            if (event->mask & IN_ISDIR) {
+                if (event->name[0] != '.' && strncmp(file, "test", 4) &&
+                    strncmp(file, "bin", 3))
+                {
+                    /* Watch new directories, files in it are added to the
+                     * project when it is rebuilt */
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        if (run_watcher_add(w, file)) {
+                            ut_raise();
+                        }
+                    }
+                    ut_log("#[grey]detected change in directory '%s'\n", file);
+                    result = true;
+                }
+            } else if (filter_path(file)) {
+                ut_log("#[grey]detected change in file '%s'\n", file);
+                result = true;
+            }
+
+            free(file);
+        }
+    }
+
+    return result;
+}
+
+/* Wait for changes with inotify. Returns -1 if directory can't be watched, in
+ * which case the caller falls back to polling. */
+static
+int16_t wait_for_changes_inotify(
+    ut_proc pid,
+    const char *project_dir,
+    const char *app_bin,
+    ut_ll *changed_out)
+{
+    run_watcher w = {
+        .fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC),
+        .project_dir = project_dir
+    };
+
+    if (w.fd == -1) {
+        ut_throw("failed to initialize inotify: %s", strerror(errno));
+        goto error;
+    }
+
+    if (run_watcher_add(&w, NULL)) {
+        run_watcher_free(&w);
+        goto error;
+    }
+
+    struct timespec first_change, last_change;
+    bool changed = false;
+
+    do {
+        struct pollfd pfd = {.fd = w.fd, .events = POLLIN};
+
+        /* Wake up every 50ms to check if process is still running */
+        int ret = poll(&pfd, 1, 50);
+
+        if (pid) {
+            if ((retcode = ut_proc_check(pid, NULL))) {
+                break;
+            }
+        }
+
+        if (ret > 0 && run_watcher_read(&w)) {
+            timespec_gettime(&last_change);
+            if (!changed) {
+                first_change = last_change;
+                changed = true;
+            }
+        }
+
+        /* Don't rebuild until a burst of changes (like a checkout, or an editor
+         * writing a file in multiple steps) has finished */
+        if (changed) {
+            struct timespec now;
+            timespec_gettime(&now);
+            if (timespec_toDouble(timespec_sub(now, last_change)) >= RUN_DEBOUNCE ||
+                timespec_toDouble(timespec_sub(now, first_change)) >= RUN_DEBOUNCE_MAX)
+            {
+                break;
+            }
+        }
+    } while (true);
+
+    run_watcher_free(&w);
+
+    if (changed) {
+        *changed_out = NULL;
+        add_changed(changed_out, (char*)app_bin);
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+#endif
+
+static
+ut_ll wait_for_changes(
+    ut_proc pid,
+    const char *project_dir,
+    const char *app_bin,
+    ut_ll changed)
+{
+    if (changed) {
+        ut_ll_free(changed);
+        changed = NULL;
+    }
+
+#ifdef UT_OS_LINUX
+    static bool inotify_failed = false;
+
+    if (!inotify_failed) {
+        if (!wait_for_changes_inotify(pid, project_dir, app_bin, &changed)) {
+            return changed;
+        }
+
+        ut_raise();
+        ut_warning("cannot watch '%s' for changes, falling back to polling",
+            project_dir);
+        inotify_failed = true;
+    }
+#endif
+
+    return wait_for_changes_poll(pid, project_dir, app_bin, changed);
+}
+
 static
 int build_project(
     const char *path)
@@ -116,6 +116,7 @@ int16_t bake_create_upgrade_script(void)
     fprintf(f, "bake.exe setup --local\n");
     fprintf(f, "\n\n");
     fclose(f);
+    ut_stat_cache_invalidate(script_path);
 
     free(script_path);
 
@@ -154,6 +155,7 @@ int16_t bake_create_script(bool local, bool nopass)
     fprintf(f, "cmd /c %%USERPROFILE%%\\bake\\"BAKE_EXEC".exe %%*\n");
     fprintf(f, ")\n\n");
     fclose(f);
+    ut_stat_cache_invalidate(script_file_path);
 
     free(vc_shell_cmd);
     free(script_file_path);
@@ -210,6 +212,7 @@ int16_t bake_create_upgrade_script(void)
     fprintf(f, "    ./bake setup --upgrade\n");
     fprintf(f, "fi\n");
     fclose(f);
+    ut_stat_cache_invalidate(script_path);
 
     /* Make executable for user */
     if (ut_setperm(script_path, 0700)) {
@@ -250,6 +253,7 @@ int16_t bake_create_script(bool local, bool nopass)
     fprintf(f, "   exec $HOME/bake/"BAKE_EXEC" \"$@\"\n");
     fprintf(f, "fi\n");
     fclose(f);
+    ut_stat_cache_invalidate(script_path);
 
     /* Make executable for everyone */
     if (ut_setperm(script_path, 0755)) {
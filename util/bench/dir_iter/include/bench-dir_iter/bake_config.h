@@ -0,0 +1,27 @@
+/*
+                                   )
+                                  (.)
+                                  .|.
+                                  | |
+                              _.--| |--._
+                           .-';  ;`-'& ; `&.
+                          \   &  ;    &   &_/
+                           |"""---...---"""|
+                           \ | | | | | | | /
+                            `---.|.|.|.---'
+
+ * This file is generated by bake.lang.c for your convenience. Headers of
+ * dependencies will automatically show up in this file. Include bake_config.h
+ * in your main project file. Do not edit! */
+
+#ifndef BENCH_DIR_ITER_BAKE_CONFIG_H
+#define BENCH_DIR_ITER_BAKE_CONFIG_H
+
+/* Headers of public dependencies */
+/* No dependencies */
+#ifdef __BAKE__
+#include <bake_util.h>
+#endif
+
+#endif
+
@@ -0,0 +1,8 @@
+#ifndef BENCH_DIR_ITER_H
+#define BENCH_DIR_ITER_H
+
+/* This generated file contains includes for project dependencies */
+#include "bench-dir_iter/bake_config.h"
+
+#endif
+
@@ -0,0 +1,198 @@
+/* Benchmark for ut_dir_iter with file patterns, like the ones used to select
+ * source files of a project.
+ *
+ * Usage: dir_iter [path] [files]
+ *
+ * Creates a tree with the specified number of empty files (100000 by default)
+ * in path (bench_tree by default) if it doesn't exist yet. Files are spread
+ * over 10 directories with 100 subdirectories each, with 10 extensions. The
+ * benchmark then reports the best of 15 runs of:
+ *  - ut_dir_iter for each pattern. To compare implementations of ut_dir_iter,
+ *    run the benchmark with each version of the bake_util library (for example
+ *    by pointing LD_LIBRARY_PATH to the lib directory of another bake home).
+ *  - matching all file names in the tree against each pattern with a compiled
+ *    program (ut_expr_compile/ut_expr_run) and with ut_expr, which parses the
+ *    pattern for every name. */
+
+#include <bench_dir_iter.h>
+
+#define BENCH_RUNS (15)
+#define BENCH_DIRS (10)
+#define BENCH_SUBDIRS (100)
+
+static const char *exts[] = {
+    "c", "h", "cpp", "txt", "o", "json", "md", "cxx", "py", "d"
+};
+
+static const char *patterns[] = {
+    "//*.c|*.cpp|*.cxx",
+    "//*.c",
+    "//f1?.c|*.h",
+    "//*",
+    NULL
+};
+
+static
+int16_t create_tree(
+    const char *path,
+    int files)
+{
+    int per_dir = files / (BENCH_DIRS * BENCH_SUBDIRS);
+    int d, s, f;
+
+    printf("creating %d files in '%s'\n", per_dir * BENCH_DIRS * BENCH_SUBDIRS,
+        path);
+
+    for (d = 0; d < BENCH_DIRS; d ++) {
+        for (s = 0; s < BENCH_SUBDIRS; s ++) {
+            char *dir = ut_asprintf("%s/m%d/d%d", path, d, s);
+            if (ut_mkdir(dir)) {
+                free(dir);
+                goto error;
+            }
+
+            for (f = 0; f < per_dir; f ++) {
+                char *file = ut_asprintf("%s/f%d.%s", dir, f, exts[f % 10]);
+                int16_t ret = ut_touch(file);
+                free(file);
+                if (ret) {
+                    ut_throw("failed to create file in '%s'", dir);
+                    free(dir);
+                    goto error;
+                }
+            }
+
+            free(dir);
+        }
+    }
+
+    return 0;
+error:
+    return -1;
+}
+
+static
+double cpu_time(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static
+int16_t bench_dir_iter(
+    const char *path,
+    const char *pattern,
+    ut_ll names)
+{
+    double best = 0;
+    int i, count = 0;
+
+    for (i = 0; i < BENCH_RUNS; i ++) {
+        double start = cpu_time();
+        ut_iter it;
+
+        if (ut_dir_iter(path, pattern, &it)) {
+            goto error;
+        }
+
+        count = 0;
+        while (ut_iter_hasNext(&it)) {
+            char *file = ut_iter_next(&it);
+            if (names && !i) {
+                const char *name = strrchr(file, '/');
+                ut_ll_append(names, ut_strdup(name ? name + 1 : file));
+            }
+            count ++;
+        }
+
+        double t = cpu_time() - start;
+        if (!i || t < best) {
+            best = t;
+        }
+    }
+
+    printf("  ut_dir_iter %-20s %7d files %8.3fs\n", pattern, count, best);
+
+    return 0;
+error:
+    return -1;
+}
+
+static
+void bench_match(
+    const char *pattern,
+    ut_ll names)
+{
+    ut_expr_program program = ut_expr_compile(pattern, true, true);
+    double best_compiled = 0, best_parsed = 0;
+    int i, matched = 0;
+
+    for (i = 0; i < BENCH_RUNS; i ++) {
+        double start = cpu_time();
+        ut_iter it = ut_ll_iter(names);
+
+        matched = 0;
+        while (ut_iter_hasNext(&it)) {
+            matched += ut_expr_run(program, ut_iter_next(&it));
+        }
+
+        double t = cpu_time() - start;
+        if (!i || t < best_compiled) {
+            best_compiled = t;
+        }
+
+        start = cpu_time();
+        it = ut_ll_iter(names);
+        while (ut_iter_hasNext(&it)) {
+            ut_expr(pattern, ut_iter_next(&it));
+        }
+
+        t = cpu_time() - start;
+        if (!i || t < best_parsed) {
+            best_parsed = t;
+        }
+    }
+
+    printf("  match       %-20s %7d names %8.3fs (ut_expr %.3fs)\n",
+        pattern, matched, best_compiled, best_parsed);
+
+    ut_expr_free(program);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "bench_tree";
+    int files = argc > 2 ? atoi(argv[2]) : 100000;
+    ut_ll names = ut_ll_new();
+    int i;
+
+    ut_init(argv[0]);
+
+    if (ut_file_test(path) != 1) {
+        if (create_tree(path, files)) {
+            goto error;
+        }
+    }
+
+    for (i = 0; patterns[i]; i ++) {
+        /* Collect names of all files in the tree for the matching benchmark */
+        if (bench_dir_iter(path, patterns[i], i == 3 ? names : NULL)) {
+            goto error;
+        }
+    }
+
+    for (i = 0; patterns[i]; i ++) {
+        bench_match(patterns[i], names);
+    }
+
+    ut_iter it = ut_ll_iter(names);
+    while (ut_iter_hasNext(&it)) {
+        free(ut_iter_next(&it));
+    }
+    ut_ll_free(names);
+    ut_deinit();
+
+    return 0;
+error:
+    ut_raise();
+    ut_deinit();
+    return -1;
+}
@@ -49,11 +49,26 @@ typedef struct ut_exprOp {
     bool containsWildcard;
 } ut_exprOp;
 
+typedef enum ut_expr_globKind {
+    UT_EXPR_GLOB_ANY,      /* '*' */
+    UT_EXPR_GLOB_SUFFIX,   /* '*' followed by literal, like '*.c' */
+    UT_EXPR_GLOB_LITERAL,  /* identifier without wildcards */
+    UT_EXPR_GLOB_FILTER    /* other filters, matched with ut_fnmatch */
+} ut_expr_globKind;
+
+typedef struct ut_expr_glob {
+    ut_expr_globKind kind;
+    const char *str; /* Points to tokens. For suffixes, excludes the '*' */
+    uint32_t len;
+} ut_expr_glob;
+
 struct ut_expr_program_s {
-    int kind; /* 0 = default, 1 = identifier, 2 = this, 3 = /, 4 = // */
+    int kind; /* 0 = default, 1 = identifier, 2 = this, 3 = /, 4 = //, 5 = globs */
     ut_exprOp ops[UT_EXPR_MAX_OP];
     uint8_t size;
     char *tokens;
+    ut_expr_glob *globs; /* Alternatives for a single element (kind 5) */
+    uint8_t glob_count;
 };
 
 
@@ -61,6 +61,49 @@ UT_API
 char* ut_file_load(
     const char* file);
 
+/** Initial value for a 64 bit FNV-1a hash. */
+#define UT_HASH_INIT (14695981039346656037ULL)
+
+/** Continue hash with a buffer.
+ * The hash is a 64 bit FNV-1a hash, which is the same hash as computed by
+ * ut_file_hash. Start a new hash with UT_HASH_INIT.
+ *
+ * @param hash The hash to continue.
+ * @param data The data to add to the hash.
+ * @param size The size of the data.
+ * @return The new hash.
+ */
+UT_API
+uint64_t ut_hash_buf(
+    uint64_t hash,
+    const void *data,
+    size_t size);
+
+/** Continue hash with a string.
+ * Same as ut_hash_buf, for a NULL-terminated string.
+ *
+ * @param hash The hash to continue.
+ * @param str The string to add to the hash.
+ * @return The new hash.
+ */
+UT_API
+uint64_t ut_hash_str(
+    uint64_t hash,
+    const char *str);
+
+/** Compute hash of file contents.
+ * The hash is a 64 bit FNV-1a hash, which is fast to compute and good enough to
+ * detect whether a file has changed. It is not a cryptographic hash.
+ *
+ * @param file The file to hash.
+ * @param hash_out Out parameter for the hash.
+ * @return 0 if success, non-zero if failed.
+ */
+UT_API
+int16_t ut_file_hash(
+    const char* file,
+    uint64_t *hash_out);
+
 /** Open file, walk through lines in file using an iterator.
  *
  * @param file The file to load.
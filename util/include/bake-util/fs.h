@@ -68,6 +68,38 @@ UT_API
 void ut_closedir(
     ut_ll dir);
 
+/** Directory entry returned by ut_dir_entries */
+typedef struct ut_dir_entry {
+    char *name;
+    bool is_dir;
+} ut_dir_entry;
+
+/** Read contents of a directory with the type of each entry.
+ * Where the platform provides the type of an entry when reading a directory,
+ * no additional stat calls are needed. Symbolic links are resolved. The "."
+ * and ".." entries are not returned.
+ *
+ * @param name The name of the directory to read.
+ * @param entries_out Out parameter for array with entries.
+ * @param count_out Out parameter for number of entries.
+ * @return 0 if success, non-zero if failed.
+ */
+UT_API
+int16_t ut_dir_entries(
+    const char *name,
+    ut_dir_entry **entries_out,
+    uint32_t *count_out);
+
+/** Release resources from ut_dir_entries.
+ *
+ * @param entries Array returned by ut_dir_entries.
+ * @param count Number of entries in array.
+ */
+UT_API
+void ut_dir_entries_free(
+    ut_dir_entry *entries,
+    uint32_t count);
+
 /** Returns contents of a directory in iterator.
  * Resources will be automatically cleaned up when the iterator yields no more
  * results. When iteration is prematurely stopped, call ut_iter_release.
@@ -253,6 +285,63 @@ UT_API
 time_t ut_lastmodified(
     const char *name);
 
+/* File status, as stored in the stat cache */
+typedef struct ut_file_status {
+    bool exists;
+    bool is_dir;
+    time_t modified;
+} ut_file_status;
+
+/** Enable or disable the stat cache.
+ * When enabled, ut_file_test, ut_isdir and ut_lastmodified remember the status
+ * of each path, so that a file is stat'ed only once. Functions in this library
+ * that create, modify or remove files update the cache, and so does waiting
+ * for a child process. Files that are written by other means must be passed to
+ * ut_stat_cache_invalidate. Disabling the cache clears it.
+ *
+ * The cache only sees changes made by the same copy of this library. Code that
+ * writes files with another copy (like drivers) must run while the cache is
+ * suspended.
+ *
+ * @param enable Whether to enable the cache.
+ */
+UT_API
+void ut_stat_cache_enable(
+    bool enable);
+
+/** Suspend the stat cache.
+ * While suspended, file status is not read from or added to the cache. Calls
+ * can be nested, and must be matched by ut_stat_cache_resume.
+ */
+UT_API
+void ut_stat_cache_suspend(void);
+
+/** Resume the stat cache.
+ * Clears the cache, since files may have changed while it was suspended.
+ */
+UT_API
+void ut_stat_cache_resume(void);
+
+/** Remove path from the stat cache.
+ *
+ * @param path Path that changed, or NULL to clear the cache.
+ */
+UT_API
+void ut_stat_cache_invalidate(
+    const char *path);
+
+/** Get status of path from the stat cache.
+ *
+ * @param path Path to get the status for.
+ * @param status_out Status of path.
+ * @return true if status was obtained, false if the cache is disabled or the
+ *         status could not be determined.
+ */
+UT_API
+bool ut_stat_cache_get(
+    const char *path,
+    ut_file_status *status_out);
+
 bool ut_dir_hasNext(
     ut_iter *it);
 
@@ -224,6 +224,25 @@ void ut_log_handlerRegister(
 UT_API
 bool ut_log_handlerRegistered(void);
 
+/** Capture console output of the current thread in a buffer.
+ * While a buffer is set, messages that would otherwise be printed to the
+ * console by the current thread are appended to the buffer instead. This
+ * allows an application to print the output of a task in one piece.
+ *
+ * @param buf Buffer to append output to, or NULL to print to the console.
+ * @return The previously set buffer.
+ */
+UT_API
+ut_strbuf* ut_log_capture(
+    ut_strbuf *buf);
+
+/** Get capture buffer of the current thread.
+ *
+ * @return The buffer set by ut_log_capture, or NULL if not capturing.
+ */
+UT_API
+ut_strbuf* ut_log_captured(void);
+
 
 /* -- Logging messages to console -- */
 
@@ -129,9 +129,34 @@ int ut_proc_cmd(
 
 UT_API
 int ut_proc_cmd_stderr_only(
-    char* cmd, 
+    char* cmd,
     int8_t *rc);
 
+/** Run a process (non-blocking).
+ * Splits up the command in the same way as ut_proc_cmd, but does not wait for
+ * the process to exit. Use ut_proc_wait to obtain the result.
+ *
+ * @param cmd Process to run.
+ * @return Handle to process, 0 if failed.
+ */
+UT_API
+ut_proc ut_proc_cmd_run(
+    char *cmd);
+
+/** Run a process, redirect stdout and stderr (non-blocking).
+ * Splits up the command in the same way as ut_proc_cmd.
+ *
+ * @param cmd Process to run.
+ * @param out File to redirect stdout to.
+ * @param err File to redirect stderr to.
+ * @return Handle to process, 0 if failed.
+ */
+UT_API
+ut_proc ut_proc_cmd_runRedirect(
+    char *cmd,
+    FILE *out,
+    FILE *err);
+
 /** Function that checks if process is being traced (experimental)
  *
  * @return non-zero if being traced, otherwise 0.
@@ -229,7 +229,8 @@ typedef int (*ut_equals_cb)(void *context, const void* o1, const void* o2);
 
 /* Type for traversing a tree */
 #ifndef HEIGHT_LIMIT
-#define HEIGHT_LIMIT (24) /* 16M nodes in a single tree */
+/* A red black tree with n nodes is at most 2 * log2(n + 1) high */
+#define HEIGHT_LIMIT (64) /* 4G nodes in a single tree */
 #endif
 
 typedef struct jsw_rbtrav jsw_rbtrav_t;
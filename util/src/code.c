@@ -104,6 +104,7 @@ error:
 
 void ut_code_close(ut_code *file) {
     fclose(file->file);
+    ut_stat_cache_invalidate(file->name);
     free(file->name);
     free(file);
 }
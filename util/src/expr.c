@@ -205,6 +205,8 @@ int16_t ut_exprParseIntern(
 
     data->size = 0;
     data->kind = 0;
+    data->globs = NULL;
+    data->glob_count = 0;
     data->tokens = ut_strdup(expr);
     strlower(data->tokens);
 
@@ -348,6 +350,136 @@ error:
     return -1;
 }
 
+static
+int ut_expr_globCompare(
+    const void *g1,
+    const void *g2)
+{
+    const ut_expr_glob *glob1 = g1, *glob2 = g2;
+    return glob1->kind - glob2->kind;
+}
+
+/* Compile expressions that are a list of alternatives for a single element,
+ * like the patterns that select source files ("*.c|*.cpp" in a tree), into a
+ * list of globs that can be matched without evaluating the program. */
+static
+void ut_expr_compileGlobs(
+    ut_expr_program program)
+{
+    ut_exprOp *ops = program->ops;
+    int i = 0, count = 0;
+
+    /* A leading scope or tree operator doesn't change how a single element
+     * is matched, only how deep ut_dir_iter searches */
+    if (ops[0].token == UT_EXPR_TOKEN_SCOPE ||
+        ops[0].token == UT_EXPR_TOKEN_TREE)
+    {
+        i ++;
+    }
+
+    int first = i;
+    for (; i < program->size; i ++) {
+        ut_exprToken token = ops[i].token;
+        if ((i - first) % 2) {
+            if (token != UT_EXPR_TOKEN_OR) {
+                return;
+            }
+        } else {
+            if (token != UT_EXPR_TOKEN_IDENTIFIER &&
+                token != UT_EXPR_TOKEN_FILTER)
+            {
+                return;
+            }
+            count ++;
+        }
+    }
+
+    if (!count || !((program->size - first) % 2)) {
+        return;
+    }
+
+    program->globs = malloc(count * sizeof(ut_expr_glob));
+    program->glob_count = count;
+
+    for (i = first, count = 0; i < program->size; i += 2, count ++) {
+        ut_expr_glob *glob = &program->globs[count];
+        const char *str = ops[i].start;
+
+        if (!strcmp(str, "*")) {
+            glob->kind = UT_EXPR_GLOB_ANY;
+        } else if (ops[i].token == UT_EXPR_TOKEN_IDENTIFIER) {
+            glob->kind = UT_EXPR_GLOB_LITERAL;
+        } else if (str[0] == '*' && !strpbrk(&str[1], "*?")) {
+            glob->kind = UT_EXPR_GLOB_SUFFIX;
+            str ++;
+        } else {
+            glob->kind = UT_EXPR_GLOB_FILTER;
+        }
+
+        glob->str = str;
+        glob->len = strlen(str);
+    }
+
+    /* Test cheapest globs first */
+    qsort(program->globs, program->glob_count, sizeof(ut_expr_glob),
+        ut_expr_globCompare);
+
+    program->kind = 5;
+}
+
+/* Returns 1 if string matches, 0 if it doesn't and -1 if the string can't be
+ * matched with globs, in which case the program must be evaluated. */
+static
+int ut_expr_runGlobs(
+    ut_expr_program program,
+    const char *str)
+{
+    char id[256];
+    bool lowered = false;
+    uint32_t i, len = strlen(str);
+
+    /* Elements never match '.' */
+    if (!strcmp(str, ".")) {
+        return 0;
+    }
+
+    for (i = 0; i < program->glob_count; i ++) {
+        ut_expr_glob *glob = &program->globs[i];
+        switch(glob->kind) {
+        case UT_EXPR_GLOB_ANY:
+            return 1;
+        case UT_EXPR_GLOB_SUFFIX:
+            if (len >= glob->len &&
+                !stricmp(&str[len - glob->len], glob->str))
+            {
+                return 1;
+            }
+            break;
+        case UT_EXPR_GLOB_LITERAL:
+            if (len == glob->len && !stricmp(str, glob->str)) {
+                return 1;
+            }
+            break;
+        case UT_EXPR_GLOB_FILTER:
+            /* Tokens are lowercase, so match against lowercase string */
+            if (!lowered) {
+                if (len >= sizeof(id)) {
+                    return -1;
+                }
+                strcpy(id, str);
+                strlower(id);
+                lowered = true;
+            }
+            if (!ut_fnmatch(glob->str, id)) {
+                return 1;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
 ut_expr_program ut_expr_compile(
     const char *expr,
     bool allowScopes,
@@ -356,6 +488,7 @@ ut_expr_program ut_expr_compile(
     ut_expr_program result = malloc(sizeof(struct ut_expr_program_s));
     result->kind = 0;
     result->tokens = NULL;
+    result->globs = NULL;
 
     ut_debug("match: compile expression '%s'", expr);
     if (ut_exprParseIntern(result, expr, allowScopes, allowSeparators) || !result->size) {
@@ -399,6 +532,10 @@ ut_expr_program ut_expr_compile(
         }
     }
 
+    if (!result->kind) {
+        ut_expr_compileGlobs(result);
+    }
+
     return result;
 error:
     return NULL;
@@ -558,7 +695,15 @@ bool ut_expr_run(
         return false;
     }
 
-    if (program->kind == 0) {
+    /* Globs only match a single element */
+    if (program->kind == 5 && str && !strchr(str, '/')) {
+        int match = ut_expr_runGlobs(program, str);
+        if (match != -1) {
+            return match;
+        }
+    }
+
+    if (program->kind == 0 || program->kind == 5) {
         const char *elements[UT_MAX_SCOPE_DEPTH + 1];
         ut_exprOp *op = program->ops;
         const char **elem = elements;
@@ -669,6 +814,7 @@ void ut_expr_free(ut_expr_program matcher) {
         if (matcher->tokens) {
             free(matcher->tokens);
         }
+        free(matcher->globs);
         free(matcher);
     }
 }
@@ -36,6 +36,10 @@ FILE* ut_file_open(
 {
     FILE *result = fopen(filename, mode);
 
+    if (strchr(mode, 'a') || strchr(mode, 'w')) {
+        ut_stat_cache_invalidate(filename);
+    }
+
     if (!result && (strchr(mode, 'a') || strchr(mode, 'w'))) {
         if (errno == ENOENT) {
             char *dir = ut_path_dirname(filename);
@@ -102,6 +106,62 @@ error:
     return NULL;
 }
 
+uint64_t ut_hash_buf(
+    uint64_t hash,
+    const void *data,
+    size_t size)
+{
+    const unsigned char *ptr = data;
+    size_t i;
+
+    for (i = 0; i < size; i ++) {
+        hash ^= ptr[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+uint64_t ut_hash_str(
+    uint64_t hash,
+    const char *str)
+{
+    return ut_hash_buf(hash, str, strlen(str));
+}
+
+int16_t ut_file_hash(
+    const char* filename,
+    uint64_t *hash_out)
+{
+    char buffer[8192];
+    uint64_t hash = UT_HASH_INIT;
+    size_t size;
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        ut_throw("%s (%s)", strerror(errno), filename);
+        goto error;
+    }
+
+    while ((size = fread(buffer, 1, sizeof(buffer), file))) {
+        hash = ut_hash_buf(hash, buffer, size);
+    }
+
+    if (ferror(file)) {
+        ut_throw("failed to read '%s'", filename);
+        fclose(file);
+        goto error;
+    }
+
+    fclose(file);
+
+    *hash_out = hash;
+
+    return 0;
+error:
+    return -1;
+}
+
 int16_t ut_file_test(
     const char* filefmt,
     ...)
@@ -113,6 +173,12 @@ int16_t ut_file_test(
     char *file = ut_venvparse(filefmt, arglist);
     va_end(arglist);
 
+    ut_file_status status;
+    if (file && ut_stat_cache_get(file, &status)) {
+        free(file);
+        return status.exists;
+    }
+
     if (file) {
 #ifndef _WIN32
         errno = 0;
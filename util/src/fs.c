@@ -39,6 +39,7 @@ int ut_touch(const char *file) {
         if (touch) {
             fclose(touch);
         }
+        ut_stat_cache_invalidate(file);
     }
 
     return touch ? 0 : -1;
@@ -49,6 +50,10 @@ int ut_chdir(const char *dir) {
         ut_throw("%s '%s'", strerror(errno), dir);
         return -1;
     }
+
+    /* Relative paths in the stat cache now point to different files */
+    ut_stat_cache_invalidate(NULL);
+
     return 0;
 }
 
@@ -122,6 +127,8 @@ int ut_mkdir(const char *fmt, ...) {
         }
     }
 
+    ut_stat_cache_invalidate(name);
+
     ut_trace("#[cyan]mkdir %s", name);
 
     free(name);
@@ -221,11 +228,13 @@ int ut_cp_file(
 
     ut_trace("#[cyan]cp %s %s", src, dst);
 
-    if (fullDst != dst) free(fullDst);
     free(buffer);
     fclose(sourceFile);
     fclose(destinationFile);
 
+    ut_stat_cache_invalidate(fullDst);
+    if (fullDst != dst) free(fullDst);
+
     return 0;
 
 error_CloseFiles_FreeBuffer:
@@ -356,7 +365,8 @@ int16_t ut_dir_collect(
     ut_ll files,
     bool recursive)
 {
-    ut_iter it;
+    ut_dir_entry *entries;
+    uint32_t i, count;
 
     /* Move to current directory */
     if (name && name[0]) {
@@ -365,42 +375,42 @@ int16_t ut_dir_collect(
         }
     }
 
-    /* Obtain iterator to current directory */
-    if (ut_dir_iter(ut_ll_last(stack), NULL, &it)) {
+    /* Entries contain the file type, so directories can be found without a
+     * stat for each file */
+    if (ut_dir_entries(ut_ll_last(stack), &entries, &count)) {
         goto error;
     }
 
-    while (ut_iter_hasNext(&it)) {
-        char *file = ut_iter_next(&it);
+    for (i = 0; i < count; i ++) {
+        ut_dir_entry *entry = &entries[i];
 
         /* Add file to results if it matches filter */
-        char *path;
-        if (offset) {
-            path = ut_asprintf("%s"UT_OS_PS"%s"UT_OS_PS"%s", ut_dirstack_wd(stack), offset, file);
-        } else {
-            path = ut_asprintf("%s"UT_OS_PS"%s", ut_dirstack_wd(stack), file);
-        }
-        ut_path_clean(path, path);
-
-        if (ut_expr_run(filter, file)) {
+        if (ut_expr_run(filter, entry->name)) {
+            char *path;
+            if (offset) {
+                path = ut_asprintf("%s"UT_OS_PS"%s"UT_OS_PS"%s",
+                    ut_dirstack_wd(stack), offset, entry->name);
+            } else {
+                path = ut_asprintf("%s"UT_OS_PS"%s",
+                    ut_dirstack_wd(stack), entry->name);
+            }
+            ut_path_clean(path, path);
             ut_ll_append(files, path);
         }
 
-        if (!recursive) {
-            continue;
-        }
-
         /* If directory, crawl recursively */
-        char *fullpath = ut_asprintf("%s"UT_OS_PS"%s", ut_ll_last(stack), file);
-        if (ut_isdir(fullpath)) {
-            if (ut_dir_collect(file, stack, filter, offset, files, true)) {
-                free(fullpath);
+        if (recursive && entry->is_dir) {
+            if (ut_dir_collect(
+                entry->name, stack, filter, offset, files, true))
+            {
+                ut_dir_entries_free(entries, count);
                 goto error;
             }
         }
-        free(fullpath);
     }
 
+    ut_dir_entries_free(entries, count);
+
     if (name && name[0]) {
         ut_dirstack_pop(stack);
     }
@@ -412,6 +422,17 @@ stack_error:
     return -1;
 }
 
+void ut_dir_entries_free(
+    ut_dir_entry *entries,
+    uint32_t count)
+{
+    uint32_t i;
+    for (i = 0; i < count; i ++) {
+        free(entries[i].name);
+    }
+    free(entries);
+}
+
 int16_t ut_dir_iter(
     const char *name,
     const char *filter,
@@ -514,15 +535,19 @@ int16_t ut_dir_iter(
         if (ut_expr_scope(program) == 2) {
             if (ut_dir_collect(path, NULL, program, offset, files, true)) {
                 ut_throw("recursive dir_iter failed");
+                ut_expr_free(program);
                 goto error;
             }
         } else {
             if (ut_dir_collect(path, NULL, program, offset, files, false)) {
                 ut_throw("dir_iter failed");
+                ut_expr_free(program);
                 goto error;
             }
         }
 
+        ut_expr_free(program);
+
         result = ut_ll_iterAlloc(files);
         result.data = files;
         result.release = ut_dir_releaseRecursiveFilter;
@@ -595,6 +620,15 @@ time_t ut_lastmodified(
     const char *name)
 {
     struct stat attr;
+    ut_file_status status;
+
+    if (ut_stat_cache_get(name, &status)) {
+        if (!status.exists) {
+            ut_throw("failed to stat '%s' (%s)", name, strerror(ENOENT));
+            goto error;
+        }
+        return status.modified;
+    }
 
     if (stat(name, &attr) < 0) {
         ut_throw("failed to stat '%s' (%s)", name, strerror(errno));
@@ -605,3 +639,212 @@ time_t ut_lastmodified(
 error:
     return -1;
 }
+
+/* -- Stat cache -- */
+
+typedef struct ut_stat_cache_entry {
+    char *path;
+    ut_file_status status;
+} ut_stat_cache_entry;
+
+static bool ut_stat_cache_enabled;
+static ut_rb ut_stat_cache;
+static struct ut_mutex_s ut_stat_cache_lock;
+
+/* Incremented when the cache is invalidated, so that a status that was
+ * obtained before a file changed is not added to the cache afterwards. */
+static uint64_t ut_stat_cache_generation;
+
+/* Number of times the cache is suspended */
+static int32_t ut_stat_cache_suspended;
+
+static
+int ut_stat_cache_compare(
+    void *ctx,
+    const void* key1,
+    const void* key2)
+{
+    return strcmp(key1, key2);
+}
+
+/* Remove redundant separators and "." elements, so that different spellings
+ * of the same path use the same entry */
+static
+char* ut_stat_cache_key(
+    const char *path)
+{
+    char *result = malloc(strlen(path) + 1), *dst = result;
+    const char *src = path;
+    char sep = UT_OS_PS[0];
+
+    while (*src) {
+        /* Skip "./" elements */
+        if (src[0] == '.' && src[1] == sep && (src == path || src[-1] == sep)) {
+            src += 2;
+            continue;
+        }
+
+        /* Skip repeated separators */
+        if (src[0] == sep && dst != result && dst[-1] == sep) {
+            src ++;
+            continue;
+        }
+
+        *dst++ = *src++;
+    }
+
+    *dst = '\0';
+
+    return result;
+}
+
+static
+void ut_stat_cache_clear(void)
+{
+    if (ut_stat_cache) {
+        ut_iter it = ut_rb_iter(ut_stat_cache);
+        while (ut_iter_hasNext(&it)) {
+            ut_stat_cache_entry *entry = ut_iter_next(&it);
+            free(entry->path);
+            free(entry);
+        }
+        ut_rb_free(ut_stat_cache);
+        ut_stat_cache = NULL;
+    }
+}
+
+void ut_stat_cache_enable(
+    bool enable)
+{
+    if (enable && !ut_stat_cache_enabled) {
+        ut_mutex_new(&ut_stat_cache_lock);
+        ut_stat_cache_enabled = true;
+    } else if (!enable && ut_stat_cache_enabled) {
+        ut_stat_cache_enabled = false;
+        ut_stat_cache_clear();
+        ut_mutex_free(&ut_stat_cache_lock);
+    }
+}
+
+void ut_stat_cache_invalidate(
+    const char *path)
+{
+    if (!ut_stat_cache_enabled) {
+        return;
+    }
+
+    ut_mutex_lock(&ut_stat_cache_lock);
+    ut_stat_cache_generation ++;
+
+    if (!path) {
+        ut_stat_cache_clear();
+    } else if (ut_stat_cache) {
+        char *key = ut_stat_cache_key(path);
+        ut_stat_cache_entry *entry = ut_rb_remove(ut_stat_cache, key);
+        if (entry) {
+            free(entry->path);
+            free(entry);
+        }
+        free(key);
+    }
+
+    ut_mutex_unlock(&ut_stat_cache_lock);
+}
+
+void ut_stat_cache_suspend(void)
+{
+    if (!ut_stat_cache_enabled) {
+        return;
+    }
+
+    ut_mutex_lock(&ut_stat_cache_lock);
+    ut_stat_cache_suspended ++;
+    ut_stat_cache_generation ++;
+    ut_mutex_unlock(&ut_stat_cache_lock);
+}
+
+void ut_stat_cache_resume(void)
+{
+    if (!ut_stat_cache_enabled) {
+        return;
+    }
+
+    /* Code that ran while the cache was suspended may have written files */
+    ut_mutex_lock(&ut_stat_cache_lock);
+    ut_stat_cache_suspended --;
+    ut_stat_cache_generation ++;
+    ut_stat_cache_clear();
+    ut_mutex_unlock(&ut_stat_cache_lock);
+}
+
+bool ut_stat_cache_get(
+    const char *path,
+    ut_file_status *status_out)
+{
+    if (!ut_stat_cache_enabled) {
+        return false;
+    }
+
+    char *key = ut_stat_cache_key(path);
+
+    ut_mutex_lock(&ut_stat_cache_lock);
+    if (ut_stat_cache_suspended) {
+        ut_mutex_unlock(&ut_stat_cache_lock);
+        free(key);
+        return false;
+    }
+
+    ut_stat_cache_entry *entry = NULL;
+    if (ut_stat_cache) {
+        entry = ut_rb_find(ut_stat_cache, key);
+    }
+    if (entry) {
+        *status_out = entry->status;
+    }
+    uint64_t generation = ut_stat_cache_generation;
+    ut_mutex_unlock(&ut_stat_cache_lock);
+
+    if (entry) {
+        free(key);
+        return true;
+    }
+
+    struct stat attr;
+    ut_file_status status = {0};
+    if (!stat(path, &attr)) {
+        status.exists = true;
+        status.is_dir = (attr.st_mode & S_IFMT) == S_IFDIR;
+        status.modified = attr.st_mtime;
+    } else {
+        bool missing = errno == ENOENT || errno == ENOTDIR;
+#ifdef _WIN32
+        /* stat fails for paths that end with a separator on Windows */
+        missing = false;
+#endif
+        if (!missing) {
+            /* Let caller handle the error */
+            free(key);
+            return false;
+        }
+    }
+
+    ut_mutex_lock(&ut_stat_cache_lock);
+    if (generation == ut_stat_cache_generation && !ut_stat_cache_suspended) {
+        if (!ut_stat_cache) {
+            ut_stat_cache = ut_rb_new(ut_stat_cache_compare, NULL);
+        }
+        if (!ut_rb_find(ut_stat_cache, key)) {
+            entry = ut_calloc(sizeof(ut_stat_cache_entry));
+            entry->path = key;
+            entry->status = status;
+            ut_rb_set(ut_stat_cache, entry->path, entry);
+            key = NULL;
+        }
+    }
+    ut_mutex_unlock(&ut_stat_cache_lock);
+
+    free(key);
+    *status_out = status;
+
+    return true;
+}
@@ -130,6 +130,9 @@ typedef struct ut_log_tlsData {
 
     /* Detect if program is unwinding stack in case error was reported */
     void *stack_marker;
+
+    /* If set, console output is appended to this buffer */
+    ut_strbuf *capture;
 } ut_log_tlsData;
 
 static
@@ -162,6 +165,37 @@ bool ut_log_handlerRegistered(void) {
     return log_handler.cb != NULL;
 }
 
+ut_strbuf* ut_log_capture(
+    ut_strbuf *buf)
+{
+    ut_log_tlsData *data = ut_getThreadData();
+    ut_strbuf *result = data->capture;
+    data->capture = buf;
+    return result;
+}
+
+ut_strbuf* ut_log_captured(void) {
+    ut_log_tlsData *data = ut_getThreadData();
+    return data->capture;
+}
+
+static
+void ut_log_write(
+    ut_log_tlsData *data,
+    FILE *f,
+    const char *str,
+    bool newline)
+{
+    if (data->capture) {
+        ut_strbuf_appendstr(data->capture, str);
+        if (newline) {
+            ut_strbuf_appendstrn(data->capture, "\n", 1);
+        }
+    } else {
+        fprintf(f, newline ? "%s\n" : "%s", str);
+    }
+}
+
 void ut_err_notifyCallkback(
     ut_log_verbosity level,
     char *msg)
@@ -917,15 +951,15 @@ void ut_logprint(
         char *colorized = ut_log_colorize(str);
 
         if (breakAtCategory) {
-            fprintf(f, "%s", colorized);
+            ut_log_write(data, f, colorized, false);
         } else {
             if (isTail) {
-                fprintf(f, "%s\n", colorized);
+                ut_log_write(data, f, colorized, true);
                 //data->last_printed_len = printlen(colorized);
                 //ut_log_resetCursor(data);
             } else {
                 if (msg) {
-                    fprintf(f, "%s\n", colorized);
+                    ut_log_write(data, f, colorized, true);
                 }
             }
         }
@@ -1910,7 +1944,7 @@ void ut_log(char *fmt, ...) {
 
     colorized = ut_log_colorize(formatted);
     len = printlen(colorized);
-    fprintf(stdout, "%s", colorized);
+    ut_log_write(data, stdout, colorized, false);
 
     free(colorized);
     free(formatted);
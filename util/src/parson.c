@@ -1528,6 +1528,7 @@ JSON_Status json_serialize_to_file(const JSON_Value *value, const char *filename
     if (fclose(fp) == EOF) {
         return_code = JSONFailure;
     }
+    ut_stat_cache_invalidate(filename);
     json_free_serialized_string(serialized_string);
     return return_code;
 }
@@ -1588,6 +1589,7 @@ JSON_Status json_serialize_to_file_pretty(const JSON_Value *value, const char *f
     if (fclose(fp) == EOF) {
         return_code = JSONFailure;
     }
+    ut_stat_cache_invalidate(filename);
     json_free_serialized_string(serialized_string);
     return return_code;
 }
@@ -19,6 +19,11 @@
  * THE SOFTWARE.
  */
 
+/* d_type is not part of POSIX, and is hidden when building with -std=c99 */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include <bake_util.h>
 
 static
@@ -139,6 +144,10 @@ int16_t ut_getperm(
 
 bool ut_isdir(const char *path) {
     struct stat buff;
+    ut_file_status status;
+    if (ut_stat_cache_get(path, &status)) {
+        return status.is_dir;
+    }
     if (stat(path, &buff) < 0) {
         return 0;
     }
@@ -152,6 +161,14 @@ int ut_rename(const char *oldName, const char *newName) {
             oldName, newName, strerror(errno));
         goto error;
     }
+
+    /* If a directory was moved, files in it moved as well */
+    ut_stat_cache_invalidate(oldName);
+    ut_stat_cache_invalidate(newName);
+    if (ut_isdir(newName)) {
+        ut_stat_cache_invalidate(NULL);
+    }
+
     return 0;
 error:
     return -1;
@@ -190,6 +207,7 @@ int ut_rm(const char *name) {
     }
 
     if (!result) {
+        ut_stat_cache_invalidate(name);
         ut_trace("#[cyan]rm %s", name);
     }
 
@@ -217,7 +235,9 @@ error:
 
 /* Recursively remove a directory */
 int ut_rmtree(const char *name) {
-    return nftw(name, ut_rmtreeCallback, 20, FTW_DEPTH | FTW_PHYS);
+    int result = nftw(name, ut_rmtreeCallback, 20, FTW_DEPTH | FTW_PHYS);
+    ut_stat_cache_invalidate(NULL);
+    return result;
 }
 
 /* Read the contents of a directory */
@@ -244,6 +264,58 @@ ut_ll ut_opendir(const char *name) {
     return result;
 }
 
+int16_t ut_dir_entries(
+    const char *name,
+    ut_dir_entry **entries_out,
+    uint32_t *count_out)
+{
+    ut_dir_entry *entries = NULL;
+    uint32_t count = 0, size = 0;
+    struct dirent *ep;
+
+    DIR *dp = opendir(name);
+    if (!dp) {
+        ut_throw("%s: %s", name, strerror(errno));
+        return -1;
+    }
+
+    while ((ep = readdir(dp))) {
+        if (!strcmp(ep->d_name, ".") || !strcmp(ep->d_name, "..")) {
+            continue;
+        }
+
+        if (count == size) {
+            size = size ? size * 2 : 32;
+            entries = realloc(entries, size * sizeof(ut_dir_entry));
+        }
+
+        ut_dir_entry *entry = &entries[count ++];
+        entry->name = ut_strdup(ep->d_name);
+
+#ifdef DT_DIR
+        if (ep->d_type == DT_DIR) {
+            entry->is_dir = true;
+        } else if (ep->d_type != DT_UNKNOWN && ep->d_type != DT_LNK) {
+            entry->is_dir = false;
+        } else
+#endif
+        {
+            /* Type is unknown or entry is a link, which needs to be resolved */
+            struct stat buf;
+            char *path = ut_asprintf("%s/%s", name, ep->d_name);
+            entry->is_dir = !stat(path, &buf) && S_ISDIR(buf.st_mode);
+            free(path);
+        }
+    }
+
+    closedir(dp);
+
+    *entries_out = entries;
+    *count_out = count;
+
+    return 0;
+}
+
 bool ut_dir_hasNext(
     ut_iter *it)
 {
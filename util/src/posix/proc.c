@@ -84,7 +84,7 @@ ut_proc ut_proc_runRedirect(
             ut_error("failed to redirect stdout for '%s': %s", exec, strerror(errno));
             abort();
         }
-        if (out && (err != stdout)) fclose(out);
+        if (out && (out != stdout) && (out != err)) fclose(out);
 
         if (dup2(fileno(err ? err : devnull), STDERR_FILENO) < 0) {
             ut_error("failed to redirect stderr for '%s': %s", exec, strerror(errno));
@@ -136,6 +136,9 @@ int ut_proc_wait(ut_proc pid, int8_t *rc) {
         }
     } while (retry);
 
+    /* Process may have written files */
+    ut_stat_cache_invalidate(NULL);
+
     if (WIFSIGNALED(status)) {
         result = WTERMSIG(status);
     } else {
@@ -158,6 +161,11 @@ int ut_proc_check(ut_proc pid, int8_t *rc) {
     int result = 0;
 
     result = waitpid(pid, &status, WNOHANG);
+    if (result) {
+        /* Process may have written files */
+        ut_stat_cache_invalidate(NULL);
+    }
+
     if (!result) {
         /* Process did not change state, still running */
     } else if (WIFSIGNALED(status)) {
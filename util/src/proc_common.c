@@ -23,12 +23,14 @@
 
 #define BUFFER_SIZE (256)
 
-/* Simple blocking function to create and wait for a process */
+/* Split command into arguments and start process. If redirect is true, stdout
+ * and stderr are redirected to out and err (NULL discards output). */
 static
-int ut_proc_cmd_intern(
+ut_proc ut_proc_cmd_start(
     char* cmd,
-    int8_t *rc,
-    bool stderr_only)
+    bool redirect,
+    FILE *out,
+    FILE *err)
 {
     ut_proc pid;
     const char *args[UT_MAX_CMD_ARGS];
@@ -68,13 +70,13 @@ int ut_proc_cmd_intern(
     }
     args[argCount + 1] = NULL;
 
-    if (stderr_only) {
+    if (redirect) {
         if (!(pid = ut_proc_runRedirect(
             args[0],
             args,
             stdin,
-            NULL,
-            stderr)))
+            out,
+            err)))
         {
             goto error;
         }
@@ -85,10 +87,33 @@ int ut_proc_cmd_intern(
     }
 
     if (buffer != stack_buffer) free(buffer);
-    return ut_proc_wait(pid, rc);
+    return pid;
 error:
     if (buffer != stack_buffer) free(buffer);
-    return -1;
+    return 0;
+}
+
+/* Simple blocking function to create and wait for a process */
+static
+int ut_proc_cmd_intern(
+    char* cmd,
+    int8_t *rc,
+    bool stderr_only)
+{
+    ut_proc pid = ut_proc_cmd_start(cmd, stderr_only, NULL, stderr);
+    if (!pid) {
+        return -1;
+    }
+
+    return ut_proc_wait(pid, rc);
+}
+
+ut_proc ut_proc_cmd_run(char* cmd) {
+    return ut_proc_cmd_start(cmd, false, NULL, NULL);
+}
+
+ut_proc ut_proc_cmd_runRedirect(char* cmd, FILE *out, FILE *err) {
+    return ut_proc_cmd_start(cmd, true, out, err);
 }
 
 int ut_proc_cmd(char* cmd, int8_t *rc) {
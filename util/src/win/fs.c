@@ -65,6 +65,10 @@ int16_t ut_getperm(
 }
 
 bool ut_isdir(const char *path) {
+    ut_file_status status;
+    if (ut_stat_cache_get(path, &status)) {
+        return status.is_dir;
+    }
     return PathIsDirectoryA(path);
 }
 
@@ -80,6 +84,14 @@ int ut_rename(const char *oldName, const char *newName) {
             oldName, newName, strerror(errno));
         goto error;
     }
+
+    /* If a directory was moved, files in it moved as well */
+    ut_stat_cache_invalidate(oldName);
+    ut_stat_cache_invalidate(newName);
+    if (ut_isdir(newName)) {
+        ut_stat_cache_invalidate(NULL);
+    }
+
     return 0;
 error:
     return -1;
@@ -115,6 +127,7 @@ int ut_rm(const char *name) {
         /* Don't care if file doesn't exist */
     }
 
+    ut_stat_cache_invalidate(name);
     ut_trace("#[cyan]rm %s", name);
     
     return 0;
@@ -148,6 +161,8 @@ int ut_rmtree(const char *name) {
         FOF_MULTIDESTFILES | FOF_SILENT;
     fileOp.lpszProgressTitle = "";
     int result = SHFileOperation(&fileOp);
+
+    ut_stat_cache_invalidate(NULL);
     
     if (result == ERROR_FILE_NOT_FOUND || result == ERROR_PATH_NOT_FOUND) {
         return 0;
@@ -193,6 +208,50 @@ ut_ll ut_opendir(const char *name) {
     return result;
 }
 
+int16_t ut_dir_entries(
+    const char *name,
+    ut_dir_entry **entries_out,
+    uint32_t *count_out)
+{
+    WIN32_FIND_DATA ffd;
+    TCHAR szDir[MAX_PATH];
+    HANDLE hFind = INVALID_HANDLE_VALUE;
+    ut_dir_entry *entries = NULL;
+    uint32_t count = 0, size = 0;
+
+    strcpy_s(szDir, MAX_PATH, name);
+    strcat_s(szDir, MAX_PATH, TEXT("\\*"));
+
+    hFind = FindFirstFile(szDir, &ffd);
+    if (INVALID_HANDLE_VALUE == hFind) {
+        ut_throw("%s: %s", name, ut_last_win_error());
+        return -1;
+    }
+
+    do {
+        if (!strcmp(ffd.cFileName, ".") || !strcmp(ffd.cFileName, "..")) {
+            continue;
+        }
+
+        if (count == size) {
+            size = size ? size * 2 : 32;
+            entries = realloc(entries, size * sizeof(ut_dir_entry));
+        }
+
+        ut_dir_entry *entry = &entries[count ++];
+        entry->name = ut_strdup(ffd.cFileName);
+        entry->is_dir = 
+            (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    } while (FindNextFile(hFind, &ffd));
+
+    FindClose(hFind);
+
+    *entries_out = entries;
+    *count_out = count;
+
+    return 0;
+}
+
 /* opendir is POSIX function which is not available on windows platform */
 ut_dirent* opendir(const char *name)
 {
@@ -107,6 +107,9 @@ int ut_proc_kill(ut_proc hProcess, ut_procsignal sig) {
 int ut_proc_wait(ut_proc hProcess, int8_t *rc) {
     WaitForSingleObject(hProcess, INFINITE);
 
+    /* Process may have written files */
+    ut_stat_cache_invalidate(NULL);
+
     int sig = 0;
     
     if (rc) {